@@ -1,11 +1,31 @@
+#define _GNU_SOURCE   // accept4, pread/pwrite and friends on Linux
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #ifdef _WIN32
     #include <windows.h>
+    #include <io.h>
+    #include <direct.h>
+#else
+    #include <unistd.h>
+    #include <pthread.h>
+    #include <sys/mman.h>
 #endif
 #include <ctype.h>
+#include <stdarg.h>
+#include <errno.h>
+#ifdef __linux__
+    #include <signal.h>
+    #include <sys/epoll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <netinet/in.h>
+#endif
 
 /*
 ================================================================================
@@ -14,9 +34,6 @@
 */
 
 #define MAX_NAME_LENGTH 50
-#define MAX_PLAYERS 100
-#define MAX_PATH_LENGTH 1000
-#define MAZE_SIZE 10
 
 // Challenge difficulty points
 #define POINTS_COMPTE_BON 30
@@ -24,10 +41,145 @@
 #define POINTS_ROBOT 50
 #define POINTS_TRI 20
 #define POINTS_HANOI 40
+#define SCORE_HISTOGRAM_MAX 1000      // Highest score or total a histogram can count
 
 // File paths
 #define USERS_FILE "users.txt"
-#define SCORES_FILE "scores.txt"
+#define SCORES_FILE "scores.txt"      // Legacy CSV format, imported once
+#define SCORES_DB_FILE "scores.dat"   // Fixed-width binary score store
+
+// Score store layout
+#define STORE_MAGIC 0x52534143u       // "CASR"
+#define STORE_VERSION 1
+#define STORE_SCORE_SLOTS 8           // Room for future challenges
+#define STORE_READ_BATCH 1024         // Records read per chunk when indexing
+
+// Score snapshot: every player sorted by name, memory-mapped at startup
+#define SNAPSHOT_FILE "scores.snap"
+#define SNAPSHOT_MAGIC 0x50534143u    // "CASP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_INDEX_STRIDE 64      // Records per sparse index entry
+
+// Write-ahead log for score updates
+#define SCORES_WAL_FILE "scores.wal"
+#define WAL_ENTRY_MAGIC 0x4C415743u   // "CWAL"
+#define WAL_CHECKPOINT_BYTES (1 << 20) // Checkpoint once the log reaches 1 MiB
+#define WAL_CHECKPOINT_SECONDS 30     // ...or this long after the last one
+#define WAL_COMMIT_ATTEMPTS 3         // Tries at writing and syncing a group
+#define WAL_RETRY_DELAY_MS 10         // Pause between them
+
+// Sessions and server mode
+#define SESSION_LINE_MAX 1024         // Longest input line kept per session
+#define SESSION_OUTPUT_LIMIT (1 << 20) // Drop clients that stop reading
+#define SERVER_DEFAULT_ADDRESS "4242"
+#define SERVER_MAX_EVENTS 256
+
+// Compte est Bon solver
+#define COMPTE_BON_NUMBERS 6
+#define COMPTE_BON_MAX_MISS 10        // Furthest from the target that still scores
+#define SOLVER_MAX_NUMBERS 10
+#define SOLVER_VALUE_LIMIT 1000000000 // Larger intermediate values are dropped
+#define SOLVER_PARALLEL_MIN 8         // Draws this large are solved on all cores
+#define SOLVER_MAX_THREADS 16
+#define SOLVER_EXPRESSION_MAX 256
+
+// Offline Compte est Bon catalog (--build-catalog)
+#define CATALOG_FILE "compte_bon.cat"
+#define CATALOG_MAGIC 0x42434143u     // "CACB"
+#define CATALOG_VERSION 1
+#define CATALOG_TIERS 4
+#define CATALOG_TARGETS_PER_TIER 2    // Puzzles kept per draw and tier
+#define CATALOG_TARGET_MIN 100
+#define CATALOG_TARGET_MAX 899
+#define CATALOG_RARE_SOLUTIONS 8      // This few solutions makes a puzzle one tier harder
+
+// Mastermind engine
+#define MASTERMIND_VARIANT_COUNT 2
+#define MASTERMIND_MAX_PEGS 6
+#define MASTERMIND_MAX_COLORS 10
+#define MASTERMIND_MAX_OUTCOMES 729   // 3^MASTERMIND_MAX_PEGS feedback patterns
+#define MASTERMIND_MAX_ATTEMPTS 12
+#define MASTERMIND_SAMPLE_CODES 4096  // Consistent codes a hint partitions
+#define MASTERMIND_HINT_BUDGET 2000000 // Feedback evaluations per hint
+#define MASTERMIND_PARALLEL_MIN 65536 // Work below this stays on one thread
+#define MASTERMIND_HINT_COST 3        // Points per hint taken
+#define MASTERMIND_EXTRA_GUESS_COST 3 // Points per guess beyond the engine's
+
+// Course de Robots mazes
+#define MAZE_DEFAULT_SIZE 10
+#define MAZE_MIN_SIZE 5
+#define MAZE_MAX_SIZE 4096
+#define MAZE_LOOP_PERCENT 10          // Walls between rooms opened after carving
+#define MAZE_VIEW_ROWS 15             // Viewport shown for larger mazes
+#define MAZE_VIEW_COLS 30
+#define PATH_RUN_MAX 1000000000       // Longest run count accepted in a path
+#define PATH_READ_CHUNK 65536         // Bytes read at a time from a path file
+
+// Tri Ultime arrays
+#define TRI_DEFAULT_SIZE 8
+#define TRI_MIN_SIZE 4
+#define TRI_MAX_SIZE 1000000
+#define TRI_REVERSAL_MAX_SIZE 5000    // Flips and the bound cost O(n) each
+#define TRI_REVERSAL_EXACT_MAX 20     // Largest stack solved exactly
+#define TRI_SHOW_MAX 24               // Elements of the initial array shown
+#define TRI_ROW_ELEMENTS 12           // Current array: elements per screen row
+#define TRI_VIEW_ROWS 4               // and rows shown
+#define TRI_MIN_SCORE 5
+
+// Tour de Hanoi
+#define HANOI_MAX_DISKS 64            // One bit per disk in a peg mask
+#define HANOI_MAX_PEGS 8
+#define HANOI_DRAW_MAX 12             // Larger towers are summarised
+#define HANOI_MIN_SCORE 10
+
+// Leaderboard
+#define LEADERBOARD_MAX_LEVEL 32
+#define LEADERBOARD_PAGE_SIZE 10
+
+// Time-windowed challenge boards
+#define WINDOWS_FILE "windows.dat"
+#define WINDOW_MAGIC 0x57574143u      // "CAWW"
+#define WINDOW_VERSION 1
+#define WINDOW_DAYS 91                // Day buckets kept; a season is all of them
+#define WINDOW_WEEK_DAYS 7
+#define WINDOW_TOP_K 16               // Best players kept per challenge and day
+#define SECONDS_PER_DAY 86400
+
+// Attempt log (--attempt-stats)
+#define ATTEMPT_SEGMENT_FORMAT "attempts-%06d.seg"
+#define ATTEMPT_MAGIC 0x54414143u     // "CAAT"
+#define ATTEMPT_VERSION 1
+#define ATTEMPT_SEGMENT_ROWS (1 << 20) // Rows per segment file (about 29 MiB)
+#define LOG_HISTOGRAM_SUB_BITS 5      // 32 buckets per power of two, about 3% error
+#define LOG_HISTOGRAM_BUCKETS ((65 - LOG_HISTOGRAM_SUB_BITS) << LOG_HISTOGRAM_SUB_BITS)
+
+// Solve and think time histograms, merged into this file at exit
+#define TIMINGS_FILE "timings.dat"
+#define TIMINGS_MAGIC 0x4D544143u     // "CATM"
+#define TIMINGS_VERSION 1
+#define NS_PER_MS 1000000LL
+#define NS_PER_SECOND 1000000000LL
+
+// Metrics and tracing (build with -DNO_METRICS to compile them out)
+#define METRICS_FILE "metrics.prom"   // Prometheus text, on SIGUSR1 or at exit with --metrics
+#define TRACE_FILE "trace.json"       // Chrome trace of the recent spans, written alongside
+#define METRICS_MAX_THREADS 64        // Threads past this share one block
+#define TRACE_RING_SIZE 65536         // Spans kept; a power of two
+#define THREAD_LOCAL __thread         // C99 has no _Thread_local; GCC and Clang spell it this way
+#define ALIGNED(n) __attribute__((aligned(n))) // ...nor _Alignas
+
+// Storage benchmark (--bench-store)
+#define STORE_BENCH_REPS 10000        // Timed calls per function by default
+#define STORE_BENCH_WARMUP_PERCENT 10 // Untimed calls first, as a share of the reps
+#define STORE_BENCH_BUDGET_SECONDS 5  // Stop a function early past this much time
+
+// Load test (--load-test)
+#define LOAD_DEFAULT_BOTS 100
+#define LOAD_DEFAULT_SKILL 0.9        // Chance that each bot decision is the solver's
+#define LOAD_SESSIONS_PER_BOT 2       // Sessions run by default, per bot
+#define LOAD_MAX_BOTS (1 << 20)       // A bot shares its heap key with its wake time
+#define LOAD_BOARD_COMMANDS 3         // Typed on the leaderboard before leaving it
+#define LOAD_DEFAULT_DIR "loadtest"
 
 /*
 ================================================================================
@@ -35,17 +187,137 @@
 ================================================================================
 */
 
+// Challenges in menu order; each one's id is also its score slot in the
+// store, so adding one needs no change to the record format
+typedef enum {
+    CHALLENGE_COMPTE_BON,
+    CHALLENGE_MASTERMIND,
+    CHALLENGE_ROBOT,
+    CHALLENGE_TRI,
+    CHALLENGE_HANOI,
+    CHALLENGE_COUNT
+} ChallengeId;
+
+// Menu entries after the challenges
 typedef enum {
-    CHALLENGE_COMPTE_BON = 1,
-    CHALLENGE_MASTERMIND = 2,
-    CHALLENGE_ROBOT = 3,
-    CHALLENGE_TRI = 4,
-    CHALLENGE_HANOI = 5,
-    VIEW_LEADERBOARD = 6,
-    VIEW_STATS = 7,
-    EXIT = 8
+    MENU_LEADERBOARD = CHALLENGE_COUNT + 1,
+    MENU_STATS,
+    MENU_EXIT
 } MenuOption;
 
+// What a load-test bot's line asks for; latency is reported per kind
+typedef enum {
+    LOAD_OP_LOGIN,
+    LOAD_OP_MENU,           // A menu choice that opens a challenge
+    LOAD_OP_SETUP,          // Its level, variant or size
+    LOAD_OP_PLAY,           // A move, guess or answer: LOAD_OP_PLAY + ChallengeId
+    LOAD_OP_LEADERBOARD = LOAD_OP_PLAY + CHALLENGE_COUNT,
+    LOAD_OP_STATS,
+    LOAD_OP_CONTINUE,       // Enter on a paused screen
+    LOAD_OP_EXIT,
+    LOAD_OP_COUNT
+} LoadOp;
+
+// How the Mastermind engine rates a candidate guess
+typedef enum {
+    MASTERMIND_ENTROPY,     // Most information about the secret
+    MASTERMIND_KNUTH        // Smallest worst-case set of remaining codes
+} MastermindStrategy;
+
+// Shortest path searches on a maze grid
+typedef enum {
+    PATH_BFS,
+    PATH_BIDIRECTIONAL,
+    PATH_ASTAR,
+    PATH_JPS,               // A* over jump points only
+    PATH_ALGORITHM_COUNT
+} PathAlgorithm;
+
+// What a Course de Robots line longer than one input buffer turns out to be,
+// decided from its start
+typedef enum {
+    ROBOT_STREAM_NONE,
+    ROBOT_STREAM_PATH,      // A bare path, judged at the end of the line
+    ROBOT_STREAM_TRY,       // 'try' and a path, previewed without ending the game
+    ROBOT_STREAM_IGNORE     // Anything else; dropped
+} RobotStream;
+
+// Operation a Tri Ultime player sorts with
+typedef enum {
+    TRI_SWAP,               // Any two elements
+    TRI_ADJACENT,           // Two neighbours
+    TRI_REVERSAL,           // Reverse a prefix
+    TRI_MODEL_COUNT
+} TriModel;
+
+// Columns of an attempt log segment, widest first so each stays aligned
+typedef enum {
+    ATTEMPT_TIMESTAMP,      // int64 Unix seconds
+    ATTEMPT_EFFORT,         // uint64 moves, guesses, steps or distance
+    ATTEMPT_PLAYER,         // int32 registration order in users.txt
+    ATTEMPT_DURATION,       // uint32 milliseconds
+    ATTEMPT_SCORE,          // int32, 0 when failed or skipped
+    ATTEMPT_CHALLENGE,      // uint8 ChallengeId
+    ATTEMPT_COLUMN_COUNT
+} AttemptColumn;
+
+// Counters summed across threads; _NS ones are exported in seconds
+typedef enum {
+    METRIC_SESSIONS,
+    METRIC_INPUT_LINES,
+    METRIC_INPUT_NS,
+    METRIC_RENDERS,
+    METRIC_RENDER_NS,
+    METRIC_RENDER_BYTES,
+    METRIC_OUTPUT_BYTES,
+    METRIC_USER_LOOKUPS,
+    METRIC_SCORE_LOADS,
+    METRIC_SCORE_LOAD_NS,
+    METRIC_STORE_READS,
+    METRIC_STORE_READ_BYTES,
+    METRIC_SCORE_SAVES,
+    METRIC_SCORE_SAVE_NS,
+    METRIC_STORE_WRITE_BYTES,
+    METRIC_WAL_COMMITS,
+    METRIC_WAL_COMMIT_NS,
+    METRIC_WAL_BYTES,
+    METRIC_WAL_FAILURES,
+    METRIC_LEADERBOARD_VIEWS,
+    METRIC_LEADERBOARD_NS,
+    METRIC_ATTEMPTS_LOGGED,
+    METRIC_COUNT
+} MetricId;
+
+// Spans recorded in the trace ring
+typedef enum {
+    TRACE_INPUT,            // One input line handled; arg is the screen
+    TRACE_RENDER,           // One frame diffed; arg is the bytes emitted
+    TRACE_LEADERBOARD,      // arg is the challenge shown, -1 for totals
+    TRACE_SCORE_LOAD,       // arg is the store slot
+    TRACE_SCORE_SAVE,
+    TRACE_WAL_COMMIT,       // arg is the entries made durable
+    TRACE_EVENT_COUNT
+} TraceEventId;
+
+// Screen a session is waiting for input on
+typedef enum {
+    SCREEN_LOGIN,
+    SCREEN_MENU,
+    SCREEN_PAUSE,
+    SCREEN_LEADERBOARD,
+    SCREEN_COMPTE_BON_LEVEL,
+    SCREEN_COMPTE_BON,
+    SCREEN_MASTERMIND_VARIANT,
+    SCREEN_MASTERMIND,
+    SCREEN_ROBOT_SIZE,
+    SCREEN_ROBOT,
+    SCREEN_TRI_SETUP,
+    SCREEN_TRI,
+    SCREEN_HANOI_SIZE,
+    SCREEN_HANOI,
+    SCREEN_CLOSED
+} Screen;
+
 typedef enum {
     WALL = '#',
     EMPTY = '.',
@@ -62,11 +334,7 @@ typedef enum {
 
 typedef struct {
     char name[MAX_NAME_LENGTH];
-    int compte_bon_score;
-    int mastermind_score;
-    int robot_score;
-    int tri_score;
-    int hanoi_score;
+    int scores[STORE_SCORE_SLOTS]; // Best score per challenge, by ChallengeId
     int total_score;
     int challenges_completed;
 } Player;
@@ -76,1093 +344,7743 @@ typedef struct {
     int y;
 } Position;
 
+// On-disk header of the score store
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t score_slots;
+} StoreHeader;
+
+// One fixed-width player record in the score store (104 bytes)
+typedef struct {
+    char name[MAX_NAME_LENGTH];
+    uint16_t flags;
+    int32_t scores[STORE_SCORE_SLOTS];
+    int32_t total_score;
+    int32_t challenges_completed;
+    uint32_t reserved;
+    int64_t updated_at;
+} ScoreRecord;
+
+// Bump allocator for interned names; blocks never move once allocated
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
+
+typedef struct {
+    const char* name;   // Interned copy, NULL for an empty slot
+    uint32_t hash;
+    int32_t value;
+} NameIndexEntry;
+
+// Open-addressing hash table from interned names to an int value
+typedef struct {
+    NameIndexEntry* entries;
+    size_t capacity;    // Always a power of two
+    size_t count;
+    ArenaBlock* arena;
+} NameIndex;
+
+// On-disk header of the score snapshot. The file holds every registered
+// player and every stored record, sorted by name, after the score
+// histograms; a sparse index of every SNAPSHOT_INDEX_STRIDE-th name follows
+// the records. It is only trusted while the store and the users log still
+// have the size and modification time they had when it was written.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t index_stride;
+    uint64_t count;             // Records
+    uint64_t index_count;
+    uint64_t store_records;     // Store slots in use
+    uint64_t users;             // Registered users, numbered 0..users-1
+    int64_t store_size;
+    int64_t store_mtime_ns;
+    int64_t users_size;
+    int64_t users_mtime_ns;
+    uint64_t histograms_offset;
+    uint64_t histograms_size;
+    uint64_t records_offset;
+    uint64_t index_offset;
+} SnapshotHeader;
+
+// One player in the snapshot (112 bytes)
+typedef struct {
+    ScoreRecord record;         // Name, and the scores when slot >= 0
+    int32_t slot;               // Store slot, -1 for a player who never scored
+    int32_t user;               // Line in users.txt, -1 if not registered
+} SnapshotRecord;
+
+// Growable list of snapshot records, while a new snapshot is written
+typedef struct {
+    SnapshotRecord* records;
+    size_t count;
+    size_t capacity;
+} SnapshotList;
+
+// A snapshot as mapped at runtime; header is NULL when there is none
+typedef struct {
+    void* map;
+    size_t size;
+    const SnapshotHeader* header;
+    const SnapshotRecord* records;
+    const char (*index)[MAX_NAME_LENGTH];
+} ScoreSnapshot;
+
+// Called whenever a record is loaded, imported or replayed into the store;
+// previous is NULL when the slot was empty
+typedef void (*RecordVisitor)(int slot, const ScoreRecord* previous, const ScoreRecord* record);
+
+typedef struct {
+    int fd;
+    int record_count;   // Includes slots reserved but not yet written
+    NameIndex index;    // Player name -> record slot
+    ScoreRecord** cache; // Records read or saved by this process, by slot
+    int cache_capacity;
+    RecordVisitor on_load;
+    const ScoreSnapshot* snapshot; // When set, index only holds players added since
+} ScoreStore;
+
+// One checksummed log entry (128 bytes)
+typedef struct {
+    uint32_t magic;
+    uint32_t checksum;  // CRC-32 of seq, slot and record
+    uint64_t seq;
+    int32_t slot;       // Store slot the writer applies the record to
+    uint32_t reserved;
+    ScoreRecord record;
+} WalEntry;
+
+typedef struct {
+    WalEntry* entries;
+    int count;
+    int capacity;
+} WalQueue;
+
+// Score updates are queued here and made durable by one writer thread,
+// which appends each group with a single write and a single fsync
+typedef struct {
+    int fd;
+    long long size;
+    uint64_t next_seq;
+    WalQueue queue;
+    ScoreStore* store;
+    time_t last_checkpoint;
+    int running;
+    uint64_t lock_waits;    // Appends that found the writer holding the lock
+    int64_t lock_wait_ns;   // Time those appends spent blocked
+    int queue_peak;         // Most updates queued at once
+    uint64_t batches;       // Groups committed, and the updates in them
+    uint64_t batched;
+    uint64_t failed;        // Updates the log could not hold, synced to the store instead
+    uint64_t lost;          // ...of which the store could not be synced either
+    #ifndef _WIN32
+        pthread_t writer;
+        pthread_mutex_t lock;
+        pthread_cond_t wake;
+    #endif
+} WriteAheadLog;
+
+// Skip list node; links[i].span counts the nodes skipped by links[i].next
+typedef struct LeaderNode {
+    const char* name;
+    int slot;
+    int total_score;
+    int challenges_completed;
+    int64_t achieved_at;
+    int level;
+    struct {
+        struct LeaderNode* next;
+        int span;
+    } links[];
+} LeaderNode;
+
+// Order-statistic skip list ordered by (total desc, achieved_at asc)
+typedef struct {
+    LeaderNode* head;
+    int level;
+    int count;
+    LeaderNode** by_slot;   // Store slot -> node, for O(log n) updates
+    int by_slot_capacity;
+    ArenaBlock* names;
+    uint32_t seed;
+} Leaderboard;
+
+// Count of players per score value, as a Fenwick tree for prefix sums
+typedef struct {
+    int max_value;
+    int count;
+    int tree[SCORE_HISTOGRAM_MAX + 2];
+} ScoreHistogram;
+
+// Best scores stored column-wise: one dense array per challenge indexed by
+// store slot, so a per-challenge ranking or aggregate reads one column
+typedef struct {
+    int32_t* columns[CHALLENGE_COUNT];
+    int capacity;
+    int rows;               // Highest slot seen + 1
+} ScoreColumns;
+
+// One player's best result in a bucket, by store slot
+typedef struct {
+    int32_t slot;
+    int32_t score;
+} WindowEntry;
+
+// Everything kept about one UTC day: attempt counts and a top-K per
+// challenge (1072 bytes on disk)
+typedef struct {
+    int64_t day;            // Days since the epoch; any other day means stale
+    uint32_t attempts[STORE_SCORE_SLOTS];
+    uint8_t counts[STORE_SCORE_SLOTS];
+    WindowEntry top[STORE_SCORE_SLOTS][WINDOW_TOP_K]; // Best first
+} WindowBucket;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t bucket_size;
+    uint32_t days;
+} WindowHeader;
+
+// Ring of day buckets indexed by day % WINDOW_DAYS, so a bucket is reused
+// (and its old day rolls off) once the ring comes around
+typedef struct {
+    int fd;
+    WindowBucket buckets[WINDOW_DAYS];
+} WindowBoards;
+
+// Attempt log segment header; the columns follow, ATTEMPT_SEGMENT_ROWS each
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;      // Rows per column
+    uint32_t rows;          // Rows written; written last, after the cells
+} AttemptSegmentHeader;
+
+// One finished attempt, before it is split into columns
+typedef struct {
+    int64_t timestamp;
+    uint64_t effort;
+    int32_t player;
+    uint32_t duration_ms;
+    int32_t score;
+    uint8_t challenge;
+} AttemptRow;
+
+// Every attempt ever finished, appended to fixed-size columnar segments
+typedef struct {
+    int fd;                 // Segment being filled, -1 until the first append
+    int segment;
+    uint32_t rows;
+    char* map;              // That segment mapped for writing; NULL where mmap is unavailable
+} AttemptLog;
+
+// Log-bucketed counts: values below 2^LOG_HISTOGRAM_SUB_BITS are exact,
+// larger ones keep their top LOG_HISTOGRAM_SUB_BITS + 1 bits
+typedef struct {
+    uint64_t count;
+    uint64_t buckets[LOG_HISTOGRAM_BUCKETS];
+} LogHistogram;
+
+// Nanosecond timings per challenge: whole solves, and the gap before each
+// line typed during a challenge
+typedef struct {
+    LogHistogram solve[CHALLENGE_COUNT];
+    LogHistogram think[CHALLENGE_COUNT];
+} TimingStats;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t buckets;       // LOG_HISTOGRAM_BUCKETS
+    uint32_t challenges;    // CHALLENGE_COUNT
+} TimingsHeader;
+
+// One thread's counters, on their own cache lines
+typedef struct {
+    ALIGNED(64) uint64_t counters[METRIC_COUNT];
+} MetricsBlock;
+
+// A finished span; seq is its ring index + 1 once fully written, so a
+// reader can tell a slot being overwritten from a complete one
+typedef struct {
+    uint64_t seq;
+    int64_t start_ns;
+    int64_t duration_ns;
+    int64_t arg;
+    uint16_t event;
+    uint16_t thread;
+} TraceEvent;
+
+// Multi-producer ring: writers claim an index with one atomic add and
+// overwrite the oldest span, so recording never blocks
+typedef struct {
+    uint64_t head;          // Spans ever claimed
+    TraceEvent events[TRACE_RING_SIZE];
+} TraceRing;
+
+typedef struct {
+    const char* name;
+    const char* help;
+} MetricInfo;
+
+typedef struct {
+    const char* name;
+    MetricId duration;      // Counter the span's time is added to
+} TraceEventInfo;
+
+// State shared by the storage benchmark's calls
+typedef struct {
+    struct Session* session;    // Renders into its buffers; never flushed
+    long long players;
+    uint64_t rng;
+    char name[MAX_NAME_LENGTH];
+    Player player;
+    uint64_t found;             // Sink for results, so calls are not optimised away
+} StoreBench;
+
+// One function under benchmark: prepare sets up untimed inputs, run is timed
+typedef struct {
+    const char* name;
+    void (*prepare)(StoreBench* bench);
+    void (*run)(StoreBench* bench);
+} StoreBenchCase;
+
+// Registered users, loaded once; users.txt is the append-only log
+typedef struct {
+    NameIndex names;    // User name -> registration order
+    FILE* log;
+    const ScoreSnapshot* snapshot; // When set, names only holds users added since
+    int base;           // Users already in the snapshot
+} UserRegistry;
+
+// One reachable value, with the step that first produced it: left op right,
+// where left comes from left_mask and right from the rest of the subset
+typedef struct {
+    int32_t value;          // 0 marks an empty slot
+    int32_t left;
+    uint32_t ways;          // Distinct derivations of value (saturating)
+    uint16_t left_mask;     // 0 for one of the drawn numbers
+    char op;
+} SolverEntry;
+
+// Deduplicated values reachable using exactly the numbers of one subset
+typedef struct {
+    SolverEntry* slots;
+    size_t capacity;
+    size_t count;
+} SolverSet;
+
+typedef struct {
+    int count;
+    int target;
+    SolverSet* sets;        // Indexed by subset bitmask
+    int32_t best;           // Reachable value closest to the target
+    uint16_t best_mask;
+    int64_t best_distance;
+} CompteBonSolver;
+
+// compte_bon.cat starts with this header; records follow, sorted by tier
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+    uint32_t tier_offset[CATALOG_TIERS]; // First record of each tier
+    uint32_t tier_count[CATALOG_TIERS];
+    uint32_t reserved;
+} CatalogHeader;
+
+typedef struct {
+    uint8_t numbers[COMPTE_BON_NUMBERS];
+    uint16_t target;
+    uint32_t solutions;     // Distinct derivations of the target
+    uint8_t depth;          // Fewest operations that reach it
+    uint8_t tier;
+    uint16_t reserved;
+} CatalogPuzzle;
+
+// The catalog as mapped at runtime
+typedef struct {
+    void* map;
+    size_t size;
+    const CatalogHeader* header;
+    const CatalogPuzzle* puzzles;
+} PuzzleCatalog;
+
+// Work shared by the catalog builder threads
+typedef struct {
+    uint8_t (*draws)[COMPTE_BON_NUMBERS];
+    int draw_count;
+    CatalogPuzzle* puzzles; // A fixed block of slots per draw, target 0 if unused
+    #ifndef _WIN32
+        pthread_mutex_t lock;
+    #endif
+    int next;
+} CatalogBuild;
+
+// Board sizes a Mastermind game can be played at
+typedef struct {
+    const char* name;
+    int pegs;
+    int colors;
+    int first_color;        // Digit shown for colour 0
+    int max_attempts;
+} MastermindVariant;
+
+typedef struct {
+    const char* name;
+    const char* description;
+    const char* format;     // How one operation is typed
+    int max_size;
+} TriModelInfo;
+
+// Every code of a variant as digits, indexed by code number
+typedef struct {
+    int pegs;
+    int colors;
+    uint32_t count;         // colors^pegs
+    int outcomes;           // 3^pegs feedback patterns
+    int win;                // Feedback with every peg right
+    uint8_t (*digits)[MASTERMIND_MAX_PEGS];
+    int64_t opening[2];     // First guess per strategy, -1 until computed
+    int32_t reply[MASTERMIND_MAX_OUTCOMES]; // Solver's second guess per feedback to its opening, -1 until computed
+} MastermindTable;
+
+// Codes still consistent with every guess so far, one bit per code
+typedef struct {
+    MastermindTable* table;
+    uint64_t* consistent;
+    uint32_t remaining;
+} MastermindEngine;
+
+// Work split across threads: filtering a range of bitset words when guess
+// is set, otherwise rating a range of candidate guesses
+typedef struct {
+    MastermindEngine* engine;
+    const uint8_t* guess;
+    int feedback;
+    uint32_t kept;
+    MastermindStrategy strategy;
+    uint32_t* codes;        // Sample of consistent codes to partition
+    uint32_t code_count;
+    uint32_t* guesses;
+    double* scores;
+    size_t next;
+    size_t total;
+    size_t chunk;
+    #ifndef _WIN32
+        pthread_mutex_t lock;
+    #endif
+} MastermindJob;
+
+// A maze on a grid of cells, one bit each; the start is always 0,0
+typedef struct {
+    int rows;
+    int cols;
+    size_t stride;          // Bits per row, padded to whole words
+    uint64_t* walls;        // Set for wall cells
+    uint64_t* trail;        // Set for cells the robot went through
+    uint64_t seed;
+    int goal_row;
+    int goal_col;
+    int optimal;            // Shortest path length
+    uint32_t* distance;     // Steps to the goal per cell (row * cols + col), UINT32_MAX if cut off
+} Maze;
+
+// Walks a path through a maze as it arrives, in any number of chunks.
+// Moves are N, S, E or O, each optionally followed by a repeat count, so
+// "S12E5N3" and "SSSSSSSSSSSSEEEEENNN" are the same path.
+typedef struct {
+    int row;
+    int col;
+    long long steps;
+    char direction;         // Move whose count is being read, 0 if none
+    long long count;        // Its count so far, -1 while no digit was read
+    int valid;
+    char error[96];
+    long long detours;      // Steps that did not bring the robot closer to the goal
+    long long detour_step;  // Step on which the path first left a shortest route, -1 if never
+    int detour_row;         // Cell that step started from
+    int detour_col;
+} PathReader;
+
+// Reads Tri Ultime operations as they arrive, in any number of chunks.
+// Numbers are grouped by the model's arity ("0 5 3 4" is two swaps); ','
+// ';' and new lines also end an operation.
+typedef struct {
+    long long fields[2];
+    int count;              // Numbers complete in the current operation
+    int digits;             // Digits read of the number in progress
+    long long applied;
+    int valid;
+    char error[96];
+} TriReader;
+
+// Reads Tour de Hanoi moves as they arrive, in any number of chunks. A
+// move is two peg letters ("AC", "A C" or "A->C"); moves may follow each
+// other with or without separators.
+typedef struct {
+    char from;              // First peg of the move being read, 0 if none
+    uint64_t applied;
+    int valid;
+    char error[96];
+} HanoiReader;
+
+// Growable list of cells (row * cols + col)
+typedef struct {
+    uint32_t* cells;
+    size_t count;
+    size_t capacity;
+} CellList;
+
+// Binary min-heap of (priority << 32 | cell) keys
+typedef struct {
+    uint64_t* keys;
+    size_t count;
+    size_t capacity;
+} HeapList;
+
+// Cursor over a player's Compte est Bon answer
+typedef struct {
+    const char* at;
+    const int* numbers;
+    int count;
+    int used[SOLVER_MAX_NUMBERS];
+    int valid;
+} ExpressionParser;
+
+// Growable byte buffer, reused from one frame to the next
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} TextBuffer;
+
+// Progress of each challenge between two lines of input
+typedef struct {
+    int numbers[COMPTE_BON_NUMBERS];
+    int target;
+    int best_distance;      // 0 unless the draw cannot reach the target
+    char solution[SOLVER_EXPRESSION_MAX]; // Solved lazily for catalog puzzles
+} CompteBonGame;
+
+typedef struct {
+    int variant;
+    uint8_t secret[MASTERMIND_MAX_PEGS]; // Colours 0..colors-1
+    int attempts;
+    int max_attempts;
+    int hints;
+    MastermindEngine engine;
+    MastermindEngine solver;    // The engine's own game against the secret, one guess per player guess
+    int solver_guesses;
+    int solver_opening;         // Feedback to its first guess
+    int solver_solved;
+} MastermindGame;
+
+typedef struct {
+    Maze maze;
+    int view_row;           // Top-left cell of the viewport
+    int view_col;
+    const char* message;    // Feedback on the last command, shown above the prompt
+    PathReader reader;
+    RobotStream streaming;  // A line longer than one input buffer is arriving
+    char feedback[192];     // Result of the last 'try', pointed to by message
+} RobotGame;
+
+typedef struct {
+    int* arr;
+    int* initial;
+    int n;
+    TriModel model;
+    long long moves;
+    long long optimal;      // Fewest operations that sort the initial array
+    int exact;              // 0 when optimal is only an upper bound
+    long long descents;     // Neighbours out of order; 0 exactly when sorted
+    int view;               // First element of the current array shown
+    TriReader reader;
+    int streaming;          // A batch longer than one input buffer is arriving
+    const char* message;    // Feedback on the last input, shown above the prompt
+    char feedback[160];
+} TriGame;
+
+typedef struct {
+    uint64_t pegs[HANOI_MAX_PEGS]; // Bit d-1 set when disk d (1 = smallest) is on the peg
+    int peg_count;
+    int disks;
+    uint64_t moves;
+    uint64_t min_moves;
+    HanoiReader reader;
+    int streaming;          // A batch longer than one input buffer is arriving
+    int on_track;           // Every move so far was the reference solution's
+    const char* message;    // Feedback on the last move, shown above the prompt
+    char feedback[160];
+} HanoiGame;
+
+// Everything one connected player needs. Challenges keep their progress in
+// the game union, so one thread can interleave any number of sessions.
+typedef struct Session {
+    int fd;                     // Client socket, or -1 for the local terminal
+    Player player;
+    Screen screen;
+    int64_t attempt_started;    // clock_now_ns() when the current puzzle was dealt
+    int64_t last_input;         // clock_now_ns() at the last line typed in a challenge
+    int64_t render_started;     // When the frame being drawn was begun, for its span
+    union {
+        CompteBonGame compte_bon;
+        MastermindGame mastermind;
+        RobotGame robot;
+        TriGame tri;
+        HanoiGame hanoi;
+        struct {
+            int page;
+            int challenge;      // Board shown: a ChallengeId, or -1 for totals
+            int window;         // Days covered by a challenge board, 0 for all time
+        } leaderboard;
+    } game;
+    char line[SESSION_LINE_MAX]; // Input line being assembled
+    size_t line_len;
+    TextBuffer out;             // Output not yet written to the client
+    TextBuffer frame;           // Frame being drawn between render_begin/commit
+    TextBuffer shown;           // Last frame committed to the screen
+    TextBuffer* sink;           // Where session output currently goes
+    int shown_valid;            // Screen still shows exactly `shown`
+    int want_write;             // EPOLLOUT currently armed
+    uint64_t wal_failed_seen;   // score_wal.failed when this player was last told
+    struct Session* prev;
+    struct Session* next;
+} Session;
+
+// One entry of the challenge registry
+typedef struct {
+    const char* name;
+    const char* short_name;     // For one-line summaries
+    const char* icon;
+    int difficulty;             // Stars shown in the menu
+    int max_points;
+    void (*start)(Session* s);
+} ChallengeInfo;
+
+// One simulated player. Its session is driven in-process, so it needs no
+// socket, and it reads each puzzle straight from the session's game state.
+typedef struct {
+    Session* session;
+    int id;                     // Plays as "bot<id>"
+    uint64_t rng;
+    int plan[MENU_EXIT];        // Menu choices for this session, shuffled
+    int planned;
+    int next;                   // Plan entry to choose next; past the end, exit
+    int board_commands;         // Still to type before leaving the leaderboard
+    long long moves;            // Lines typed in the current challenge
+    int64_t session_started;
+    TextBuffer line;            // Next line to type
+} LoadBot;
+
+// Settings and results of a load test
+typedef struct {
+    LoadBot* bots;
+    int bot_count;
+    long long sessions;         // To finish in total
+    long long started;
+    long long finished;
+    int skill;                  // Per mille
+    int think_ms;
+    uint64_t lines;
+    uint64_t bytes;             // Output rendered for the bots, then dropped
+    LogHistogram ops[LOAD_OP_COUNT];
+    int64_t op_total_ns[LOAD_OP_COUNT];
+    int64_t op_max_ns[LOAD_OP_COUNT];
+    LogHistogram session_ns;    // Whole sessions, think time included
+    HeapList queue;             // (wake in microseconds << 20 | bot), earliest first
+} LoadTest;
+
 /*
 ================================================================================
     GLOBAL VARIABLES
 ================================================================================
 */
 
-Player current_player;
-char current_username[MAX_NAME_LENGTH];
+ScoreStore score_store = { -1, 0, { NULL, 0, 0, NULL }, NULL, 0, NULL, NULL };
+WriteAheadLog score_wal = { .fd = -1 };
+UserRegistry user_registry = { { NULL, 0, 0, NULL }, NULL, NULL, 0 };
+ScoreSnapshot score_snapshot;
+int rankings_pending = 0;       // Leaderboard and columns not built from the snapshot yet
+Leaderboard leaderboard;
+ScoreHistogram total_histogram;
+ScoreHistogram challenge_histograms[CHALLENGE_COUNT];
+ScoreColumns score_columns;
+WindowBoards window_boards = { .fd = -1 };
+AttemptLog attempt_log = { .fd = -1 };
+TimingStats timing_totals;      // Every process so far, for percentiles
+TimingStats timing_recent;      // This process only, merged into the file at exit
+extern const ChallengeInfo CHALLENGES[CHALLENGE_COUNT]; // See CHALLENGE REGISTRY
+PuzzleCatalog puzzle_catalog;
+uint64_t hanoi_min_moves[HANOI_MAX_DISKS + 1][HANOI_MAX_PEGS + 1]; // Frame-Stewart, saturating
+uint8_t hanoi_split[HANOI_MAX_DISKS + 1][HANOI_MAX_PEGS + 1];      // Disks parked first
+#ifndef NO_METRICS
+    MetricsBlock metrics_blocks[METRICS_MAX_THREADS + 1]; // The last is shared by any overflow
+    int metrics_thread_count;
+    THREAD_LOCAL MetricsBlock* metrics_local;
+    THREAD_LOCAL int metrics_thread_id;
+    TraceRing trace_ring;
+    #ifdef __linux__
+        volatile sig_atomic_t metrics_dump_requested = 0;
+    #endif
+#endif
 
 /*
 ================================================================================
-    UTILITY FUNCTIONS
+    METRICS AND TRACING
+    Per-thread counters and a lock-free ring of timed spans; building with
+    -DNO_METRICS turns every probe into nothing
 ================================================================================
 */
 
-// Clear the console screen
-void clear_screen() {
+// Nanoseconds on a clock that never goes backwards
+int64_t clock_now_ns() {
     #ifdef _WIN32
-        system("cls");
+        static LARGE_INTEGER frequency;
+        LARGE_INTEGER now;
+        if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&now);
+        return (int64_t)(now.QuadPart / frequency.QuadPart * NS_PER_SECOND +
+                         now.QuadPart % frequency.QuadPart * NS_PER_SECOND / frequency.QuadPart);
     #else
-        system("clear");
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (int64_t)now.tv_sec * NS_PER_SECOND + now.tv_nsec;
     #endif
 }
 
-// Wait for user to press Enter
-void pause_screen() {
-    printf("\n\nPress Enter to continue...");
-    while(getchar() != '\n');
-    getchar();
-}
+#ifdef NO_METRICS
+    // sizeof keeps the arguments "used" without evaluating them
+    #define METRIC_ADD(metric, n) ((void)sizeof(n))
+    #define TRACE_NOW() 0
+    #define TRACE_BEGIN(started) ((void)0)
+    #define TRACE_END(event, started, arg) ((void)sizeof(arg))
+#else
+    #define METRIC_ADD(metric, n) metric_add((metric), (uint64_t)(n))
+    #define TRACE_NOW() clock_now_ns()
+    #define TRACE_BEGIN(started) int64_t started = clock_now_ns()
+    #define TRACE_END(event, started, arg) trace_span((event), (started), (int64_t)(arg))
+#endif
 
-// Display a fancy header
-void display_header(const char* title) {
-    printf("\n");
-    printf("╔═══════════════════════════════════════════════════════════════════════╗\n");
-    printf("║                                                                       ║\n");
-    printf("║          %s", title);
-    // Add padding to center the title
-    int padding = 62 - strlen(title);
-    for(int i = 0; i < padding; i++) printf(" ");
-    printf("║\n");
-    printf("║                                                                       ║\n");
-    printf("╚═══════════════════════════════════════════════════════════════════════╝\n\n");
-}
+const MetricInfo METRICS[METRIC_COUNT] = {
+    [METRIC_SESSIONS]          = { "sessions_total",              "Sessions opened" },
+    [METRIC_INPUT_LINES]       = { "input_lines_total",           "Input lines handled" },
+    [METRIC_INPUT_NS]          = { "input_seconds_total",         "Time spent handling input lines" },
+    [METRIC_RENDERS]           = { "renders_total",               "Frames rendered" },
+    [METRIC_RENDER_NS]         = { "render_seconds_total",        "Time spent diffing frames" },
+    [METRIC_RENDER_BYTES]      = { "render_bytes_total",          "Bytes emitted by frame diffs" },
+    [METRIC_OUTPUT_BYTES]      = { "output_bytes_total",          "Bytes written to terminals and sockets" },
+    [METRIC_USER_LOOKUPS]      = { "user_lookups_total",          "Registered-user lookups" },
+    [METRIC_SCORE_LOADS]       = { "score_loads_total",           "Player score loads" },
+    [METRIC_SCORE_LOAD_NS]     = { "score_load_seconds_total",    "Time spent loading player scores" },
+    [METRIC_STORE_READS]       = { "store_reads_total",           "Score records read from disk" },
+    [METRIC_STORE_READ_BYTES]  = { "store_read_bytes_total",      "Bytes read from the score store" },
+    [METRIC_SCORE_SAVES]       = { "score_saves_total",           "Personal bests saved" },
+    [METRIC_SCORE_SAVE_NS]     = { "score_save_seconds_total",    "Time spent saving personal bests" },
+    [METRIC_STORE_WRITE_BYTES] = { "store_write_bytes_total",     "Bytes written to the score store" },
+    [METRIC_WAL_COMMITS]       = { "wal_commits_total",           "Log groups made durable" },
+    [METRIC_WAL_COMMIT_NS]     = { "wal_commit_seconds_total",    "Time spent writing and syncing the log" },
+    [METRIC_WAL_BYTES]         = { "wal_bytes_total",             "Bytes appended to the log" },
+    [METRIC_WAL_FAILURES]      = { "wal_failures_total",          "Log groups that could not be made durable" },
+    [METRIC_LEADERBOARD_VIEWS] = { "leaderboard_views_total",     "Leaderboard pages drawn" },
+    [METRIC_LEADERBOARD_NS]    = { "leaderboard_seconds_total",   "Time spent drawing leaderboards" },
+    [METRIC_ATTEMPTS_LOGGED]   = { "attempts_logged_total",       "Attempts appended to the attempt log" }
+};
 
-// Display the main banner
-void display_banner() {
-    printf("\n");
-    printf("  ╔════════════════════════════════════════════════════════════════════════════════╗\n");
-    printf("  ║                                                                                ║\n");
-    printf("  ║      ██████╗██╗  ██╗ █████╗ ██╗     ██╗     ███████╗███╗   ██╗ ██████╗ ███████╗║\n");
-    printf("  ║     ██╔════╝██║  ██║██╔══██╗██║     ██║     ██╔════╝████╗  ██║██╔════╝ ██╔════╝║\n");
-    printf("  ║     ██║     ███████║███████║██║     ██║     █████╗  ██╔██╗ ██║██║  ███╗█████╗  ║\n");
-    printf("  ║     ██║     ██╔══██║██╔══██║██║     ██║     ██╔══╝  ██║╚██╗██║██║   ██║██╔══╝  ║\n");
-    printf("  ║     ╚██████╗██║  ██║██║  ██║███████╗███████╗███████╗██║ ╚████║╚██████╔╝███████╗║\n");
-    printf("  ║      ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚══════╝╚══════╝╚══════╝╚═╝  ╚═══╝ ╚═════╝ ╚══════╝║\n");
-    printf("  ║                                                                                ║\n");
-    printf("  ║      █████╗ ██████╗ ███████╗███╗   ██╗ █████╗                                  ║\n");
-    printf("  ║     ██╔══██╗██╔══██╗██╔════╝████╗  ██║██╔══██╗                                 ║\n");
-    printf("  ║     ███████║██████╔╝█████╗  ██╔██╗ ██║███████║                                 ║\n");
-    printf("  ║     ██╔══██║██╔══██╗██╔══╝  ██║╚██╗██║██╔══██║                                 ║\n");
-    printf("  ║     ██║  ██║██║  ██║███████╗██║ ╚████║██║  ██║                                 ║\n");
-    printf("  ║     ╚═╝  ╚═╝╚═╝  ╚═╝╚══════╝╚═╝  ╚═══╝╚═╝  ╚═╝                                 ║\n");
-    printf("  ║                                                                                ║\n");
-    printf("  ║              🎯 CHALLENGES PLATFORM - Learn By Doing 🎯                       ║\n");
-    printf("  ║                                                                                ║\n");
-    printf("  ╚════════════════════════════════════════════════════════════════════════════════╝\n\n");
-}
+const TraceEventInfo TRACE_EVENTS[TRACE_EVENT_COUNT] = {
+    [TRACE_INPUT]       = { "input",       METRIC_INPUT_NS },
+    [TRACE_RENDER]      = { "render",      METRIC_RENDER_NS },
+    [TRACE_LEADERBOARD] = { "leaderboard", METRIC_LEADERBOARD_NS },
+    [TRACE_SCORE_LOAD]  = { "score_load",  METRIC_SCORE_LOAD_NS },
+    [TRACE_SCORE_SAVE]  = { "score_save",  METRIC_SCORE_SAVE_NS },
+    [TRACE_WAL_COMMIT]  = { "wal_commit",  METRIC_WAL_COMMIT_NS }
+};
 
-/*
-================================================================================
-    FILE HANDLING FUNCTIONS
-================================================================================
-*/
+#ifndef NO_METRICS
 
-// Check if a user exists in the users file
-int user_exists(const char* username) {
-    FILE* file = fopen(USERS_FILE, "r");
-    if (!file) return 0;
-    
-    char line[MAX_NAME_LENGTH];
-    while (fgets(line, sizeof(line), file)) {
-        line[strcspn(line, "\n")] = 0; // Remove newline
-        if (strcmp(line, username) == 0) {
-            fclose(file);
-            return 1;
-        }
+// This thread's counter block, claimed on first use
+MetricsBlock* metrics_thread() {
+    if (!metrics_local) {
+        int id = __atomic_fetch_add(&metrics_thread_count, 1, __ATOMIC_RELAXED);
+        metrics_thread_id = id < METRICS_MAX_THREADS ? id : METRICS_MAX_THREADS;
+        metrics_local = &metrics_blocks[metrics_thread_id];
     }
-    fclose(file);
-    return 0;
+    return metrics_local;
 }
 
-// Add a new user to the users file
-void add_user(const char* username) {
-    FILE* file = fopen(USERS_FILE, "a");
-    if (file) {
-        fprintf(file, "%s\n", username);
-        fclose(file);
+// A relaxed load and store on the thread's own block; only the shared
+// overflow block needs a locked add
+void metric_add(MetricId metric, uint64_t n) {
+    MetricsBlock* block = metrics_thread();
+    uint64_t* counter = &block->counters[metric];
+    if (metrics_thread_id == METRICS_MAX_THREADS) {
+        __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+    } else {
+        __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
     }
 }
 
-// Load player scores from the scores file
-void load_player_scores(Player* player) {
-    FILE* file = fopen(SCORES_FILE, "r");
-    if (!file) return;
-    
-    char name[MAX_NAME_LENGTH];
-    int cb, mm, rb, tr, hn, tot, comp;
-    
-    while (fscanf(file, "%[^,],%d,%d,%d,%d,%d,%d,%d\n", 
-                  name, &cb, &mm, &rb, &tr, &hn, &tot, &comp) == 8) {
-        if (strcmp(name, player->name) == 0) {
-            player->compte_bon_score = cb;
-            player->mastermind_score = mm;
-            player->robot_score = rb;
-            player->tri_score = tr;
-            player->hanoi_score = hn;
-            player->total_score = tot;
-            player->challenges_completed = comp;
-            break;
-        }
+uint64_t metric_total(MetricId metric) {
+    uint64_t total = 0;
+    for(int i = 0; i <= METRICS_MAX_THREADS; i++) {
+        total += __atomic_load_n(&metrics_blocks[i].counters[metric], __ATOMIC_RELAXED);
     }
-    fclose(file);
+    return total;
 }
 
-// Save player scores to the scores file
-void save_player_scores(Player* player) {
-    FILE* file = fopen(SCORES_FILE, "r");
-    FILE* temp = fopen("temp.txt", "w");
-    
-    if (!temp) return;
+// Close a span begun at started: count its time and push it on the ring
+void trace_span(TraceEventId event, int64_t started, int64_t arg) {
+    int64_t duration = clock_now_ns() - started;
+    metric_add(TRACE_EVENTS[event].duration, duration);
     
-    int found = 0;
-    if (file) {
-        char name[MAX_NAME_LENGTH];
-        int cb, mm, rb, tr, hn, tot, comp;
-        
-        while (fscanf(file, "%[^,],%d,%d,%d,%d,%d,%d,%d\n", 
-                      name, &cb, &mm, &rb, &tr, &hn, &tot, &comp) == 8) {
-            if (strcmp(name, player->name) == 0) {
-                fprintf(temp, "%s,%d,%d,%d,%d,%d,%d,%d\n",
-                       player->name, player->compte_bon_score,
-                       player->mastermind_score, player->robot_score,
-                       player->tri_score, player->hanoi_score,
-                       player->total_score, player->challenges_completed);
-                found = 1;
-            } else {
-                fprintf(temp, "%s,%d,%d,%d,%d,%d,%d,%d\n",
-                       name, cb, mm, rb, tr, hn, tot, comp);
-            }
+    uint64_t index = __atomic_fetch_add(&trace_ring.head, 1, __ATOMIC_RELAXED);
+    TraceEvent* slot = &trace_ring.events[index & (TRACE_RING_SIZE - 1)];
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->start_ns = started;
+    slot->duration_ns = duration;
+    slot->arg = arg;
+    slot->event = (uint16_t)event;
+    slot->thread = (uint16_t)metrics_thread_id;
+    __atomic_store_n(&slot->seq, index + 1, __ATOMIC_RELEASE);
+}
+
+void metrics_write_prometheus(FILE* file) {
+    for(int i = 0; i < METRIC_COUNT; i++) {
+        const MetricInfo* info = &METRICS[i];
+        uint64_t value = metric_total(i);
+        fprintf(file, "# HELP challenges_%s %s\n# TYPE challenges_%s counter\n", info->name, info->help, info->name);
+        if (strstr(info->name, "_seconds_")) {
+            fprintf(file, "challenges_%s %.9f\n", info->name, (double)value / NS_PER_SECOND);
+        } else {
+            fprintf(file, "challenges_%s %llu\n", info->name, (unsigned long long)value);
         }
-        fclose(file);
     }
+    uint64_t spans = __atomic_load_n(&trace_ring.head, __ATOMIC_RELAXED);
+    fprintf(file, "# HELP challenges_trace_spans_total Spans recorded, including those since overwritten\n");
+    fprintf(file, "# TYPE challenges_trace_spans_total counter\nchallenges_trace_spans_total %llu\n",
+            (unsigned long long)spans);
+    fprintf(file, "# HELP challenges_threads Threads that have recorded metrics\n");
+    fprintf(file, "# TYPE challenges_threads gauge\nchallenges_threads %d\n",
+            __atomic_load_n(&metrics_thread_count, __ATOMIC_RELAXED));
+}
+
+// The spans still in the ring, oldest first, as Chrome trace "complete"
+// events (load the file in chrome://tracing or Perfetto)
+void trace_write_chrome(FILE* file) {
+    uint64_t head = __atomic_load_n(&trace_ring.head, __ATOMIC_ACQUIRE);
+    uint64_t first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    int64_t origin = -1;
+    int written = 0;
     
-    if (!found) {
-        fprintf(temp, "%s,%d,%d,%d,%d,%d,%d,%d\n",
-               player->name, player->compte_bon_score,
-               player->mastermind_score, player->robot_score,
-               player->tri_score, player->hanoi_score,
-               player->total_score, player->challenges_completed);
+    fprintf(file, "{\"traceEvents\":[");
+    for(uint64_t index = first; index < head; index++) {
+        const TraceEvent* slot = &trace_ring.events[index & (TRACE_RING_SIZE - 1)];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != index + 1) continue;
+        TraceEvent event = *slot;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != index + 1) continue; // Overwritten meanwhile
+        
+        if (origin < 0) origin = event.start_ns;
+        fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"arg\":%lld}}",
+                written++ ? "," : "", TRACE_EVENTS[event.event].name, event.thread,
+                (event.start_ns - origin) / 1000.0, event.duration_ns / 1000.0, (long long)event.arg);
     }
-    
-    fclose(temp);
-    remove(SCORES_FILE);
-    rename("temp.txt", SCORES_FILE);
+    fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
 }
 
-/*
-================================================================================
-    USER MANAGEMENT FUNCTIONS
-================================================================================
-*/
+#endif
 
-// Initialize a new player with zero scores
-void initialize_player(Player* player, const char* username) {
-    strcpy(player->name, username);
-    player->compte_bon_score = 0;
-    player->mastermind_score = 0;
-    player->robot_score = 0;
-    player->tri_score = 0;
-    player->hanoi_score = 0;
-    player->total_score = 0;
-    player->challenges_completed = 0;
+// Write METRICS_FILE and TRACE_FILE; returns 0 if either could not be written
+int metrics_dump() {
+    #ifdef NO_METRICS
+        return 0;
+    #else
+        FILE* file = fopen(METRICS_FILE, "w");
+        if (!file) return 0;
+        metrics_write_prometheus(file);
+        fclose(file);
+        
+        file = fopen(TRACE_FILE, "w");
+        if (!file) return 0;
+        trace_write_chrome(file);
+        fclose(file);
+        return 1;
+    #endif
 }
 
-// Handle user login or registration
-void login_user() {
-    clear_screen();
-    display_banner();
-    
-    printf("Enter your name: ");
-    fgets(current_username, MAX_NAME_LENGTH, stdin);
-    current_username[strcspn(current_username, "\n")] = 0;
-    
-    if (user_exists(current_username)) {
-        initialize_player(&current_player, current_username);
-        load_player_scores(&current_player);
-        
-        printf("\n╔═══════════════════════════════════════════════╗\n");
-        printf("║  Welcome back, %s!", current_username);
-        int padding = 27 - strlen(current_username);
-        for(int i = 0; i < padding; i++) printf(" ");
-        printf("║\n");
-        printf("╚═══════════════════════════════════════════════╝\n");
-        printf("\n📊 Your Statistics:\n");
-        printf("   • Total Score: %d points\n", current_player.total_score);
-        printf("   • Challenges Completed: %d/5\n", current_player.challenges_completed);
-    } else {
-        add_user(current_username);
-        initialize_player(&current_player, current_username);
-        
-        printf("\n╔═══════════════════════════════════════════════╗\n");
-        printf("║  Welcome, %s!", current_username);
-        int padding = 32 - strlen(current_username);
-        for(int i = 0; i < padding; i++) printf(" ");
-        printf("║\n");
-        printf("║  Let's start your coding journey! 🚀           ║\n");
-        printf("╚════════════════════════════════════════════════╝\n");
-    }
-    
-    pause_screen();
+// Dump if SIGUSR1 arrived since the last check
+void metrics_poll() {
+    #if !defined(NO_METRICS) && defined(__linux__)
+        if (metrics_dump_requested) {
+            metrics_dump_requested = 0;
+            metrics_dump();
+        }
+    #endif
+}
+
+#if !defined(NO_METRICS) && defined(__linux__)
+void metrics_handle_signal(int sig) {
+    (void)sig;
+    metrics_dump_requested = 1;
 }
+#endif
 
 /*
 ================================================================================
-    CHALLENGE 1: LE COMPTE EST BON
-    Find operations to reach a target number from given numbers
+    RENDERING
+    Output is built in per-session buffers and written once per frame
 ================================================================================
 */
 
-// Simple expression evaluator
-int evaluate_expression(const char* expr, int* numbers, int count, int* valid) {
-    char clean[500] = {0};
-    int clean_idx = 0;
-    
-    // Remove whitespaces
-    for(int i = 0; expr[i]; i++) {
-        if (!isspace(expr[i])) {
-            clean[clean_idx++] = expr[i];
-        }
-    }
+int text_reserve(TextBuffer* b, size_t extra) {
+    if (b->len + extra < b->cap) return 1;
+    size_t capacity = b->cap ? b->cap : 4096;
+    while (capacity <= b->len + extra) capacity *= 2;
+    char* data = realloc(b->data, capacity);
+    if (!data) return 0;
+    b->data = data;
+    b->cap = capacity;
+    return 1;
+}
+
+void text_append(TextBuffer* b, const char* data, size_t len) {
+    if (!text_reserve(b, len)) return;
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+void text_vprintf(TextBuffer* b, const char* format, va_list args) {
+    va_list retry;
+    va_copy(retry, args);
+    size_t room = b->cap - b->len;
+    int n = vsnprintf(b->data ? b->data + b->len : NULL, room, format, args);
+    if (n >= 0 && (size_t)n >= room && text_reserve(b, n)) {
+        n = vsnprintf(b->data + b->len, b->cap - b->len, format, retry);
+    }
+    va_end(retry);
+    if (n > 0) b->len += n;
+}
+
+void text_printf(TextBuffer* b, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    text_vprintf(b, format, args);
+    va_end(args);
+}
+
+// Anything written outside a frame means the screen no longer matches it
+TextBuffer* session_sink(Session* s) {
+    if (s->sink == &s->out) s->shown_valid = 0;
+    return s->sink;
+}
+
+// Append formatted text to the session's pending output
+void session_printf(Session* s, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    text_vprintf(session_sink(s), format, args);
+    va_end(args);
+}
+
+// Append a string as-is (no format parsing)
+void session_puts(Session* s, const char* str) {
+    text_append(session_sink(s), str, strlen(str));
+}
+
+// Append str count times, e.g. a run of box-drawing glyphs
+void session_repeat(Session* s, const char* str, int count) {
+    TextBuffer* b = session_sink(s);
+    size_t len = strlen(str);
+    if (count <= 0 || !text_reserve(b, len * count)) return;
+    for(int i = 0; i < count; i++) {
+        memcpy(b->data + b->len, str, len);
+        b->len += len;
+    }
+}
+
+// Start drawing a full screen into the frame buffer
+void render_begin(Session* s) {
+    s->render_started = TRACE_NOW();
+    s->frame.len = 0;
+    s->sink = &s->frame;
+}
+
+// Emit the frame, rewriting only rows that differ from the one on screen.
+// The last row (usually a prompt) is always rewritten so the cursor ends
+// after it, and everything below it, such as echoed input, is cleared.
+void render_commit(Session* s) {
+    TextBuffer* out = &s->out;
+    size_t emitted = out->len;
+    s->sink = out;
+    
+    if (!s->shown_valid) {
+        text_append(out, "\033[H\033[2J", 7);
+        text_append(out, s->frame.data, s->frame.len);
+    } else {
+        const char* a = s->frame.data;
+        const char* a_end = a + s->frame.len;
+        const char* b = s->shown.data;
+        const char* b_end = b + s->shown.len;
+        
+        for(int row = 1; ; row++) {
+            const char* a_nl = memchr(a, '\n', a_end - a);
+            size_t a_len = a_nl ? (size_t)(a_nl - a) : (size_t)(a_end - a);
+            const char* b_nl = b ? memchr(b, '\n', b_end - b) : NULL;
+            size_t b_len = b_nl ? (size_t)(b_nl - b) : (size_t)(b ? b_end - b : 0);
+            
+            if (!a_nl || !b_nl || a_len != b_len || memcmp(a, b, a_len) != 0) {
+                text_printf(out, "\033[%d;1H", row);
+                text_append(out, a, a_len);
+                text_append(out, a_nl ? "\033[K" : "\033[J", 3);
+            }
+            if (!a_nl) break;
+            
+            a = a_nl + 1;
+            b = b_nl ? b_nl + 1 : NULL;
+        }
+    }
+    
+    TextBuffer shown = s->shown;
+    s->shown = s->frame;
+    s->frame = shown;
+    s->shown_valid = 1;
+    
+    METRIC_ADD(METRIC_RENDERS, 1);
+    METRIC_ADD(METRIC_RENDER_BYTES, out->len - emitted);
+    TRACE_END(TRACE_RENDER, s->render_started, out->len - emitted);
+}
+
+// Write pending output with a single write() where possible; returns 0 if
+// the client is gone
+int session_flush(Session* s) {
+    TextBuffer* out = &s->out;
+    
+    #ifdef _WIN32
+        fwrite(out->data, 1, out->len, stdout);
+        fflush(stdout);
+        METRIC_ADD(METRIC_OUTPUT_BYTES, out->len);
+        out->len = 0;
+        return 1;
+    #else
+        int fd = s->fd >= 0 ? s->fd : STDOUT_FILENO;
+        size_t sent = 0;
+        while (sent < out->len) {
+            ssize_t n = write(fd, out->data + sent, out->len - sent);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) return 0;
+            sent += n;
+        }
+        METRIC_ADD(METRIC_OUTPUT_BYTES, sent);
+        memmove(out->data, out->data + sent, out->len - sent);
+        out->len -= sent;
+        return out->len < SESSION_OUTPUT_LIMIT;
+    #endif
+}
+
+/*
+================================================================================
+    UTILITY FUNCTIONS
+================================================================================
+*/
+
+// Clear the console screen
+void clear_screen(Session* s) {
+    session_puts(s, "\033[H\033[2J");
+}
+
+// Wait for user to press Enter; the next line returns to the main menu
+void pause_screen(Session* s) {
+    session_puts(s, "\n\nPress Enter to continue...");
+    s->screen = SCREEN_PAUSE;
+}
+
+// Display a fancy header
+void display_header(Session* s, const char* title) {
+    // Add padding to center the title
+    int padding = 62 - strlen(title);
+    session_printf(s,
+        "\n"
+        "╔═══════════════════════════════════════════════════════════════════════╗\n"
+        "║                                                                       ║\n"
+        "║          %s%*s║\n"
+        "║                                                                       ║\n"
+        "╚═══════════════════════════════════════════════════════════════════════╝\n\n",
+        title, padding > 0 ? padding : 0, "");
+}
+
+// Display the main banner
+void display_banner(Session* s) {
+    session_puts(s,
+        "\n"
+        "  ╔════════════════════════════════════════════════════════════════════════════════╗\n"
+        "  ║                                                                                ║\n"
+        "  ║      ██████╗██╗  ██╗ █████╗ ██╗     ██╗     ███████╗███╗   ██╗ ██████╗ ███████╗║\n"
+        "  ║     ██╔════╝██║  ██║██╔══██╗██║     ██║     ██╔════╝████╗  ██║██╔════╝ ██╔════╝║\n"
+        "  ║     ██║     ███████║███████║██║     ██║     █████╗  ██╔██╗ ██║██║  ███╗█████╗  ║\n"
+        "  ║     ██║     ██╔══██║██╔══██║██║     ██║     ██╔══╝  ██║╚██╗██║██║   ██║██╔══╝  ║\n"
+        "  ║     ╚██████╗██║  ██║██║  ██║███████╗███████╗███████╗██║ ╚████║╚██████╔╝███████╗║\n"
+        "  ║      ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚══════╝╚══════╝╚══════╝╚═╝  ╚═══╝ ╚═════╝ ╚══════╝║\n"
+        "  ║                                                                                ║\n"
+        "  ║      █████╗ ██████╗ ███████╗███╗   ██╗ █████╗                                  ║\n"
+        "  ║     ██╔══██╗██╔══██╗██╔════╝████╗  ██║██╔══██╗                                 ║\n"
+        "  ║     ███████║██████╔╝█████╗  ██╔██╗ ██║███████║                                 ║\n"
+        "  ║     ██╔══██║██╔══██╗██╔══╝  ██║╚██╗██║██╔══██║                                 ║\n"
+        "  ║     ██║  ██║██║  ██║███████╗██║ ╚████║██║  ██║                                 ║\n"
+        "  ║     ╚═╝  ╚═╝╚═╝  ╚═╝╚══════╝╚═╝  ╚═══╝╚═╝  ╚═╝                                 ║\n"
+        "  ║                                                                                ║\n"
+        "  ║              🎯 CHALLENGES PLATFORM - Learn By Doing 🎯                       ║\n"
+        "  ║                                                                                ║\n"
+        "  ╚════════════════════════════════════════════════════════════════════════════════╝\n\n");
+}
+
+// Create dir if needed and make it the working directory
+int enter_directory(const char* dir) {
+    #ifdef _WIN32
+        _mkdir(dir);
+        return _chdir(dir) == 0;
+    #else
+        mkdir(dir, 0755);
+        return chdir(dir) == 0;
+    #endif
+}
+
+// Block the calling thread for about ns nanoseconds
+void sleep_ns(int64_t ns) {
+    if (ns <= 0) return;
+    #ifdef _WIN32
+        Sleep((DWORD)((ns + NS_PER_MS - 1) / NS_PER_MS));
+    #else
+        struct timespec delay = { (time_t)(ns / NS_PER_SECOND), (long)(ns % NS_PER_SECOND) };
+        while (nanosleep(&delay, &delay) != 0 && errno == EINTR);
+    #endif
+}
+
+/*
+================================================================================
+    NAME INDEX
+    Interned names in an open-addressing hash table (linear probing)
+================================================================================
+*/
+
+#define ARENA_BLOCK_SIZE 65536
+#define NAME_INDEX_MIN_CAPACITY 64
+
+// FNV-1a hash of a NUL-terminated string
+uint32_t hash_name(const char* name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Copy a string into the arena and return the stable copy
+const char* arena_strdup(ArenaBlock** arena, const char* str) {
+    size_t len = strlen(str) + 1;
+    ArenaBlock* block = *arena;
+    
+    if (!block || block->used + len > block->size) {
+        size_t size = len > ARENA_BLOCK_SIZE ? len : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + size);
+        if (!block) return NULL;
+        block->next = *arena;
+        block->used = 0;
+        block->size = size;
+        *arena = block;
+    }
+    
+    char* copy = block->data + block->used;
+    memcpy(copy, str, len);
+    block->used += len;
+    return copy;
+}
+
+void arena_free(ArenaBlock** arena) {
+    while (*arena) {
+        ArenaBlock* next = (*arena)->next;
+        free(*arena);
+        *arena = next;
+    }
+}
+
+void name_index_free(NameIndex* index) {
+    free(index->entries);
+    arena_free(&index->arena);
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+// Locate the slot holding name, or the empty slot where it would go
+NameIndexEntry* name_index_slot(NameIndexEntry* entries, size_t capacity,
+                                const char* name, uint32_t hash) {
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while (entries[i].name) {
+        if (entries[i].hash == hash && strcmp(entries[i].name, name) == 0) {
+            return &entries[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return &entries[i];
+}
+
+// Double the table; interned names are reused, not copied
+int name_index_grow(NameIndex* index) {
+    size_t capacity = index->capacity ? index->capacity * 2 : NAME_INDEX_MIN_CAPACITY;
+    NameIndexEntry* entries = calloc(capacity, sizeof(NameIndexEntry));
+    if (!entries) return 0;
+    
+    for(size_t i = 0; i < index->capacity; i++) {
+        NameIndexEntry* old = &index->entries[i];
+        if (old->name) {
+            *name_index_slot(entries, capacity, old->name, old->hash) = *old;
+        }
+    }
+    free(index->entries);
+    index->entries = entries;
+    index->capacity = capacity;
+    return 1;
+}
+
+// Return the value stored for name, or -1 if absent
+int name_index_find(const NameIndex* index, const char* name) {
+    if (index->count == 0) return -1;
+    NameIndexEntry* entry = name_index_slot(index->entries, index->capacity,
+                                            name, hash_name(name));
+    return entry->name ? entry->value : -1;
+}
+
+// Insert or overwrite name -> value; returns the interned name or NULL
+const char* name_index_put(NameIndex* index, const char* name, int value) {
+    // Keep the load factor under 3/4
+    if ((index->count + 1) * 4 > index->capacity * 3 && !name_index_grow(index)) {
+        return NULL;
+    }
+    
+    uint32_t hash = hash_name(name);
+    NameIndexEntry* entry = name_index_slot(index->entries, index->capacity, name, hash);
+    if (!entry->name) {
+        const char* interned = arena_strdup(&index->arena, name);
+        if (!interned) return NULL;
+        entry->name = interned;
+        entry->hash = hash;
+        index->count++;
+    }
+    entry->value = value;
+    return entry->name;
+}
+
+/*
+================================================================================
+    SCORE STORE
+    Fixed-width binary records; one positioned write per save
+================================================================================
+*/
+
+// Read exactly len bytes at offset; returns 1 on success
+int file_pread(int fd, void* buf, size_t len, long long offset) {
+    #ifdef _WIN32
+        if (_lseeki64(fd, offset, SEEK_SET) < 0) return 0;
+        return _read(fd, buf, (unsigned)len) == (int)len;
+    #else
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = pread(fd, (char*)buf + done, len - done, offset + done);
+            if (n <= 0) return 0;
+            done += n;
+        }
+        return 1;
+    #endif
+}
+
+// Write exactly len bytes at offset; returns 1 on success
+int file_pwrite(int fd, const void* buf, size_t len, long long offset) {
+    #ifdef _WIN32
+        if (_lseeki64(fd, offset, SEEK_SET) < 0) return 0;
+        return _write(fd, buf, (unsigned)len) == (int)len;
+    #else
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = pwrite(fd, (const char*)buf + done, len - done, offset + done);
+            if (n <= 0) return 0;
+            done += n;
+        }
+        return 1;
+    #endif
+}
+
+int file_open_rw(const char* path) {
+    #ifdef _WIN32
+        return _open(path, _O_RDWR | _O_CREAT | _O_BINARY, 0644);
+    #else
+        return open(path, O_RDWR | O_CREAT, 0644);
+    #endif
+}
+
+void file_close(int fd) {
+    #ifdef _WIN32
+        _close(fd);
+    #else
+        close(fd);
+    #endif
+}
+
+long long file_size(int fd) {
+    #ifdef _WIN32
+        return _lseeki64(fd, 0, SEEK_END);
+    #else
+        return lseek(fd, 0, SEEK_END);
+    #endif
+}
+
+// Flush file contents to stable storage
+int file_sync(int fd) {
+    #ifdef _WIN32
+        return _commit(fd) == 0;
+    #else
+        return fsync(fd) == 0;
+    #endif
+}
+
+int file_truncate(int fd, long long size) {
+    #ifdef _WIN32
+        return _chsize_s(fd, size) == 0;
+    #else
+        return ftruncate(fd, size) == 0;
+    #endif
+}
+
+long long store_offset(int slot) {
+    return (long long)sizeof(StoreHeader) + (long long)slot * sizeof(ScoreRecord);
+}
+
+void record_from_player(ScoreRecord* record, const Player* player) {
+    memset(record, 0, sizeof(*record));
+    snprintf(record->name, sizeof(record->name), "%s", player->name);
+    for(int i = 0; i < STORE_SCORE_SLOTS; i++) {
+        record->scores[i] = player->scores[i];
+    }
+    record->total_score = player->total_score;
+    record->challenges_completed = player->challenges_completed;
+    record->updated_at = (int64_t)time(NULL);
+}
+
+void player_from_record(Player* player, const ScoreRecord* record) {
+    for(int i = 0; i < STORE_SCORE_SLOTS; i++) {
+        player->scores[i] = record->scores[i];
+    }
+    player->total_score = record->total_score;
+    player->challenges_completed = record->challenges_completed;
+}
+
+const SnapshotRecord* snapshot_find(const ScoreSnapshot* snapshot, const char* name);
+
+// Return the record slot of a player, or -1 if they have no scores yet
+int store_find(ScoreStore* store, const char* name) {
+    int slot = name_index_find(&store->index, name);
+    if (slot < 0 && store->snapshot) {
+        const SnapshotRecord* entry = snapshot_find(store->snapshot, name);
+        if (entry) slot = entry->slot;
+    }
+    return slot;
+}
+
+// Remember the latest version of a record so later reads skip the disk
+void store_cache(ScoreStore* store, int slot, const ScoreRecord* record) {
+    if (slot >= store->cache_capacity) {
+        int capacity = store->cache_capacity ? store->cache_capacity : 1024;
+        while (capacity <= slot) capacity *= 2;
+        ScoreRecord** cache = realloc(store->cache, capacity * sizeof(ScoreRecord*));
+        if (!cache) return;
+        memset(cache + store->cache_capacity, 0,
+               (capacity - store->cache_capacity) * sizeof(ScoreRecord*));
+        store->cache = cache;
+        store->cache_capacity = capacity;
+    }
+    if (!store->cache[slot]) {
+        store->cache[slot] = malloc(sizeof(ScoreRecord));
+        if (!store->cache[slot]) return;
+    }
+    *store->cache[slot] = *record;
+}
+
+// Read a record, from the cache when this process has already seen it
+int store_read(ScoreStore* store, int slot, ScoreRecord* record) {
+    if (slot < 0 || slot >= store->record_count) return 0;
+    if (slot < store->cache_capacity && store->cache[slot]) {
+        *record = *store->cache[slot];
+        return 1;
+    }
+    if (store->fd < 0 || !file_pread(store->fd, record, sizeof(*record), store_offset(slot))) {
+        return 0;
+    }
+    METRIC_ADD(METRIC_STORE_READS, 1);
+    METRIC_ADD(METRIC_STORE_READ_BYTES, sizeof(*record));
+    store_cache(store, slot, record);
+    return 1;
+}
+
+// Find and read a player's record: from the cache once this process has
+// seen it, else straight from the snapshot's mapped pages, else from disk.
+// Returns the slot, or -1 if the player has no scores.
+int store_load(ScoreStore* store, const char* name, ScoreRecord* record) {
+    int slot = name_index_find(&store->index, name);
+    if (slot < 0 && store->snapshot) {
+        const SnapshotRecord* entry = snapshot_find(store->snapshot, name);
+        if (!entry || entry->slot < 0) return -1;
+        slot = entry->slot;
+        // Every record changed since the snapshot is in the cache
+        if (slot >= store->cache_capacity || !store->cache[slot]) {
+            *record = entry->record;
+            return slot;
+        }
+    }
+    return store_read(store, slot, record) ? slot : -1;
+}
+
+// Return the player's slot, assigning the next free one on first save
+int store_reserve(ScoreStore* store, const char* name) {
+    int slot = store_find(store, name);
+    if (slot >= 0) return slot;
+    
+    slot = store->record_count;
+    if (!name_index_put(&store->index, name, slot)) return -1;
+    store->record_count++;
+    return slot;
+}
+
+// Positioned write of one record; safe to call from the log writer thread
+int store_write(ScoreStore* store, int slot, const ScoreRecord* record) {
+    if (store->fd < 0) return 0;
+    METRIC_ADD(METRIC_STORE_WRITE_BYTES, sizeof(*record));
+    return file_pwrite(store->fd, record, sizeof(*record), store_offset(slot));
+}
+
+// Synchronously overwrite the player's record in place, appending it on first
+// save; calls on_load with the record it replaced
+int store_put(ScoreStore* store, const ScoreRecord* record) {
+    ScoreRecord previous;
+    int slot = store_find(store, record->name);
+    int existed = store_read(store, slot, &previous);
+    
+    slot = store_reserve(store, record->name);
+    if (slot < 0 || !store_write(store, slot, record)) return 0;
+    
+    store_cache(store, slot, record);
+    if (store->on_load) store->on_load(slot, existed ? &previous : NULL, record);
+    return 1;
+}
+
+// Build the name index with one sequential pass over the records
+int store_build_index(ScoreStore* store, long long file_size) {
+    ScoreRecord* batch = malloc(STORE_READ_BATCH * sizeof(ScoreRecord));
+    if (!batch) return 0;
+    
+    // A torn trailing record from an interrupted append is ignored
+    int total = (int)((file_size - (long long)sizeof(StoreHeader)) / sizeof(ScoreRecord));
+    
+    for(int first = 0; first < total; first += STORE_READ_BATCH) {
+        int n = total - first < STORE_READ_BATCH ? total - first : STORE_READ_BATCH;
+        if (!file_pread(store->fd, batch, n * sizeof(ScoreRecord), store_offset(first))) {
+            free(batch);
+            return 0;
+        }
+        for(int i = 0; i < n; i++) {
+            batch[i].name[MAX_NAME_LENGTH - 1] = '\0';
+            if (!batch[i].name[0]) continue;
+            name_index_put(&store->index, batch[i].name, first + i);
+            if (store->on_load) store->on_load(first + i, NULL, &batch[i]);
+        }
+    }
+    
+    store->record_count = total;
+    free(batch);
+    return 1;
+}
+
+// One-shot import of the legacy name,cb,mm,rb,tr,hn,total,completed CSV
+int store_import_csv(ScoreStore* store, const char* csv_path) {
+    FILE* file = fopen(csv_path, "r");
+    if (!file) return 0;
+    
+    Player player;
+    int imported = 0;
+    memset(&player, 0, sizeof(player));
+    
+    while (fscanf(file, "%49[^,],%d,%d,%d,%d,%d,%d,%d\n",
+                  player.name, &player.scores[CHALLENGE_COMPTE_BON], &player.scores[CHALLENGE_MASTERMIND],
+                  &player.scores[CHALLENGE_ROBOT], &player.scores[CHALLENGE_TRI], &player.scores[CHALLENGE_HANOI],
+                  &player.total_score, &player.challenges_completed) == 8) {
+        ScoreRecord record;
+        record_from_player(&record, &player);
+        if (store_put(store, &record)) imported++;
+    }
+    fclose(file);
+    return imported;
+}
+
+// Open (or create) the store and index it; a new store imports the CSV
+int store_open(ScoreStore* store, const char* path, const char* legacy_csv) {
+    store->fd = file_open_rw(path);
+    if (store->fd < 0) return 0;
+    
+    StoreHeader header;
+    long long size = file_size(store->fd);
+    
+    if (size < (long long)sizeof(StoreHeader)) {
+        header.magic = STORE_MAGIC;
+        header.version = STORE_VERSION;
+        header.record_size = sizeof(ScoreRecord);
+        header.score_slots = STORE_SCORE_SLOTS;
+        if (!file_pwrite(store->fd, &header, sizeof(header), 0)) goto fail;
+        store->record_count = 0;
+        if (legacy_csv) store_import_csv(store, legacy_csv);
+        file_sync(store->fd);
+        return 1;
+    }
+    
+    if (!file_pread(store->fd, &header, sizeof(header), 0) ||
+        header.magic != STORE_MAGIC || header.version != STORE_VERSION ||
+        header.record_size != sizeof(ScoreRecord)) {
+        goto fail;
+    }
+    
+    // The snapshot already knows every name; only new ones are indexed
+    if (store->snapshot) {
+        store->record_count = (int)store->snapshot->header->store_records;
+        return 1;
+    }
+    if (store_build_index(store, size)) return 1;
+    
+fail:
+    file_close(store->fd);
+    store->fd = -1;
+    name_index_free(&store->index);
+    return 0;
+}
+
+void store_close(ScoreStore* store) {
+    if (store->fd >= 0) file_close(store->fd);
+    for(int i = 0; i < store->cache_capacity; i++) {
+        free(store->cache[i]);
+    }
+    free(store->cache);
+    store->cache = NULL;
+    store->cache_capacity = 0;
+    store->fd = -1;
+    store->record_count = 0;
+    name_index_free(&store->index);
+}
+
+/*
+================================================================================
+    WRITE-AHEAD LOG
+    Checksummed score updates, group-committed by a background writer
+================================================================================
+*/
+
+// CRC-32 (IEEE, reflected), table built on first use
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
+    static uint32_t table[256];
+    static int table_ready = 0;
+    
+    if (!table_ready) {
+        for(uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for(int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        table_ready = 1;
+    }
+    
+    const unsigned char* bytes = data;
+    crc = ~crc;
+    for(size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t wal_checksum(const WalEntry* entry) {
+    uint32_t crc = crc32_update(0, &entry->seq, sizeof(entry->seq));
+    crc = crc32_update(crc, &entry->slot, sizeof(entry->slot));
+    return crc32_update(crc, &entry->record, sizeof(entry->record));
+}
+
+int wal_queue_push(WalQueue* queue, const WalEntry* entry) {
+    if (queue->count == queue->capacity) {
+        int capacity = queue->capacity ? queue->capacity * 2 : 64;
+        WalEntry* entries = realloc(queue->entries, capacity * sizeof(WalEntry));
+        if (!entries) return 0;
+        queue->entries = entries;
+        queue->capacity = capacity;
+    }
+    queue->entries[queue->count++] = *entry;
+    return 1;
+}
+
+// Make a group durable with one write and one fsync, then apply it to the store.
+// A group the log cannot take is retried, then written and synced to the
+// store directly so it still survives a crash
+void wal_commit_batch(WriteAheadLog* wal, const WalEntry* entries, int count) {
+    TRACE_BEGIN(started);
+    size_t bytes = count * sizeof(WalEntry);
+    int committed = 0;
+    for(int attempt = 0; attempt < WAL_COMMIT_ATTEMPTS && !committed; attempt++) {
+        if (attempt > 0) sleep_ns(WAL_RETRY_DELAY_MS * NS_PER_MS);
+        // Nothing advances until the group is synced; a retry rewrites it in place
+        committed = file_pwrite(wal->fd, entries, bytes, wal->size) && file_sync(wal->fd);
+    }
+    if (committed) {
+        wal->size += bytes;
+        wal->batches++;
+        wal->batched += count;
+        METRIC_ADD(METRIC_WAL_COMMITS, 1);
+        METRIC_ADD(METRIC_WAL_BYTES, bytes);
+    } else {
+        // Drop what may have reached the file, or a replay could apply it
+        // after newer entries written over its start
+        file_truncate(wal->fd, wal->size);
+        METRIC_ADD(METRIC_WAL_FAILURES, 1);
+    }
+    TRACE_END(TRACE_WAL_COMMIT, started, count);
+    
+    int stored = 1;
+    for(int i = 0; i < count; i++) {
+        stored &= store_write(wal->store, entries[i].slot, &entries[i].record);
+    }
+    // Counted only: this is the writer thread, so the sessions' menus and
+    // game_state_close report it
+    if (!committed) {
+        stored = stored && file_sync(wal->store->fd);
+        if (!stored) __atomic_fetch_add(&wal->lost, count, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&wal->failed, count, __ATOMIC_RELAXED);
+    }
+}
+
+// Snapshot the store to disk, then compact the log down to nothing
+void wal_checkpoint(WriteAheadLog* wal) {
+    wal->last_checkpoint = time(NULL);
+    if (wal->size == 0 || !file_sync(wal->store->fd)) return;
+    if (file_truncate(wal->fd, 0)) wal->size = 0;
+}
+
+int wal_checkpoint_due(const WriteAheadLog* wal) {
+    return wal->size >= WAL_CHECKPOINT_BYTES ||
+           (wal->size > 0 && time(NULL) - wal->last_checkpoint >= WAL_CHECKPOINT_SECONDS);
+}
+
+#ifndef _WIN32
+// Writer thread: drain whatever queued up during the last fsync as one group
+void* wal_writer_main(void* arg) {
+    WriteAheadLog* wal = arg;
+    WalQueue batch = { NULL, 0, 0 };
+    
+    pthread_mutex_lock(&wal->lock);
+    while(1) {
+        if (wal->queue.count == 0 && wal->running) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += WAL_CHECKPOINT_SECONDS;
+            pthread_cond_timedwait(&wal->wake, &wal->lock, &deadline);
+        }
+        if (wal->queue.count == 0 && !wal->running) break;
+        
+        WalQueue full = wal->queue;
+        wal->queue = batch;
+        batch = full;
+        pthread_mutex_unlock(&wal->lock);
+        
+        if (batch.count > 0) wal_commit_batch(wal, batch.entries, batch.count);
+        batch.count = 0;
+        if (wal_checkpoint_due(wal)) wal_checkpoint(wal);
+        
+        pthread_mutex_lock(&wal->lock);
+    }
+    pthread_mutex_unlock(&wal->lock);
+    
+    free(batch.entries);
+    return NULL;
+}
+#endif
+
+// Queue a score update; returns without touching the disk
+void wal_append(WriteAheadLog* wal, int slot, const ScoreRecord* record) {
+    if (wal->fd < 0) {
+        if (wal->store) store_write(wal->store, slot, record);
+        return;
+    }
+    
+    WalEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.magic = WAL_ENTRY_MAGIC;
+    entry.slot = slot;
+    entry.record = *record;
+    
+    #ifndef _WIN32
+        if (wal->running) {
+            // Only time the lock when the writer is holding it
+            if (pthread_mutex_trylock(&wal->lock) != 0) {
+                int64_t before = clock_now_ns();
+                pthread_mutex_lock(&wal->lock);
+                wal->lock_waits++;
+                wal->lock_wait_ns += clock_now_ns() - before;
+            }
+            entry.seq = wal->next_seq++;
+            entry.checksum = wal_checksum(&entry);
+            wal_queue_push(&wal->queue, &entry);
+            if (wal->queue.count > wal->queue_peak) wal->queue_peak = wal->queue.count;
+            pthread_cond_signal(&wal->wake);
+            pthread_mutex_unlock(&wal->lock);
+            return;
+        }
+    #endif
+    
+    // No writer thread: commit a group of one inline
+    entry.seq = wal->next_seq++;
+    entry.checksum = wal_checksum(&entry);
+    wal_commit_batch(wal, &entry, 1);
+    if (wal_checkpoint_due(wal)) wal_checkpoint(wal);
+}
+
+// Re-apply every intact entry left by a previous run; stops at a torn tail
+int wal_replay(WriteAheadLog* wal) {
+    long long size = file_size(wal->fd);
+    int replayed = 0;
+    WalEntry entry;
+    
+    for(long long offset = 0; offset + (long long)sizeof(entry) <= size; offset += sizeof(entry)) {
+        if (!file_pread(wal->fd, &entry, sizeof(entry), offset) ||
+            entry.magic != WAL_ENTRY_MAGIC || entry.checksum != wal_checksum(&entry)) {
+            break;
+        }
+        entry.record.name[MAX_NAME_LENGTH - 1] = '\0';
+        if (store_put(wal->store, &entry.record)) replayed++;
+        if (entry.seq >= wal->next_seq) wal->next_seq = entry.seq + 1;
+    }
+    return replayed;
+}
+
+// Open the log, recover from it, and start the writer thread
+int wal_open(WriteAheadLog* wal, const char* path, ScoreStore* store) {
+    memset(wal, 0, sizeof(*wal));
+    wal->store = store;
+    wal->next_seq = 1;
+    wal->fd = store->fd >= 0 ? file_open_rw(path) : -1;
+    if (wal->fd < 0) return 0;
+    
+    wal_replay(wal);
+    wal->size = file_size(wal->fd);
+    wal_checkpoint(wal);
+    
+    #ifndef _WIN32
+        pthread_mutex_init(&wal->lock, NULL);
+        pthread_cond_init(&wal->wake, NULL);
+        wal->running = 1;
+        if (pthread_create(&wal->writer, NULL, wal_writer_main, wal) != 0) {
+            wal->running = 0;
+        }
+    #endif
+    return 1;
+}
+
+// Flush everything still queued, checkpoint, and stop the writer
+void wal_close(WriteAheadLog* wal) {
+    if (wal->fd < 0) return;
+    
+    #ifndef _WIN32
+        if (wal->running) {
+            pthread_mutex_lock(&wal->lock);
+            wal->running = 0;
+            pthread_cond_signal(&wal->wake);
+            pthread_mutex_unlock(&wal->lock);
+            pthread_join(wal->writer, NULL);
+        }
+        pthread_mutex_destroy(&wal->lock);
+        pthread_cond_destroy(&wal->wake);
+    #endif
+    
+    wal_checkpoint(wal);
+    file_close(wal->fd);
+    free(wal->queue.entries);
+    wal->fd = -1;
+}
+
+/*
+================================================================================
+    LEADERBOARD
+    Order-statistic skip list, updated in O(log n) on every personal best
+================================================================================
+*/
+
+int leaderboard_init(Leaderboard* lb) {
+    memset(lb, 0, sizeof(*lb));
+    lb->head = calloc(1, sizeof(LeaderNode) + LEADERBOARD_MAX_LEVEL * sizeof(lb->head->links[0]));
+    if (!lb->head) return 0;
+    lb->head->level = LEADERBOARD_MAX_LEVEL;
+    lb->level = 1;
+    lb->seed = (uint32_t)time(NULL) | 1u;
+    return 1;
+}
+
+void leaderboard_free(Leaderboard* lb) {
+    LeaderNode* node = lb->head;
+    while (node) {
+        LeaderNode* next = node->links[0].next;
+        free(node);
+        node = next;
+    }
+    free(lb->by_slot);
+    arena_free(&lb->names);
+    memset(lb, 0, sizeof(*lb));
+}
+
+// Ranking order: higher total first, then whoever reached it first
+int leader_before(const LeaderNode* a, const LeaderNode* b) {
+    if (a->total_score != b->total_score) return a->total_score > b->total_score;
+    if (a->achieved_at != b->achieved_at) return a->achieved_at < b->achieved_at;
+    return a->slot < b->slot;
+}
+
+// Geometric level with p = 1/4 (xorshift32)
+int leaderboard_random_level(Leaderboard* lb) {
+    int level = 1;
+    for(;;) {
+        lb->seed ^= lb->seed << 13;
+        lb->seed ^= lb->seed >> 17;
+        lb->seed ^= lb->seed << 5;
+        if ((lb->seed & 3) != 0 || level == LEADERBOARD_MAX_LEVEL) return level;
+        level++;
+    }
+}
+
+void leaderboard_link(Leaderboard* lb, LeaderNode* node) {
+    LeaderNode* update[LEADERBOARD_MAX_LEVEL];
+    int rank[LEADERBOARD_MAX_LEVEL];
+    LeaderNode* x = lb->head;
+    
+    for(int i = lb->level - 1; i >= 0; i--) {
+        rank[i] = (i == lb->level - 1) ? 0 : rank[i + 1];
+        while (x->links[i].next && leader_before(x->links[i].next, node)) {
+            rank[i] += x->links[i].span;
+            x = x->links[i].next;
+        }
+        update[i] = x;
+    }
+    
+    if (node->level > lb->level) {
+        for(int i = lb->level; i < node->level; i++) {
+            rank[i] = 0;
+            update[i] = lb->head;
+            update[i]->links[i].span = lb->count;
+        }
+        lb->level = node->level;
+    }
+    
+    for(int i = 0; i < node->level; i++) {
+        node->links[i].next = update[i]->links[i].next;
+        update[i]->links[i].next = node;
+        node->links[i].span = update[i]->links[i].span - (rank[0] - rank[i]);
+        update[i]->links[i].span = (rank[0] - rank[i]) + 1;
+    }
+    for(int i = node->level; i < lb->level; i++) {
+        update[i]->links[i].span++;
+    }
+    lb->count++;
+}
+
+void leaderboard_unlink(Leaderboard* lb, LeaderNode* node) {
+    LeaderNode* update[LEADERBOARD_MAX_LEVEL];
+    LeaderNode* x = lb->head;
+    
+    for(int i = lb->level - 1; i >= 0; i--) {
+        while (x->links[i].next && leader_before(x->links[i].next, node)) {
+            x = x->links[i].next;
+        }
+        update[i] = x;
+    }
+    
+    for(int i = 0; i < lb->level; i++) {
+        if (update[i]->links[i].next == node) {
+            update[i]->links[i].span += node->links[i].span - 1;
+            update[i]->links[i].next = node->links[i].next;
+        } else {
+            update[i]->links[i].span--;
+        }
+    }
+    while (lb->level > 1 && !lb->head->links[lb->level - 1].next) {
+        lb->level--;
+    }
+    lb->count--;
+}
+
+// Insert or reposition the player stored at slot
+void leaderboard_update(Leaderboard* lb, int slot, const char* name,
+                        int total_score, int challenges_completed, int64_t achieved_at) {
+    if (slot < 0) return;
+    
+    if (slot >= lb->by_slot_capacity) {
+        int capacity = lb->by_slot_capacity ? lb->by_slot_capacity : 1024;
+        while (capacity <= slot) capacity *= 2;
+        LeaderNode** by_slot = realloc(lb->by_slot, capacity * sizeof(LeaderNode*));
+        if (!by_slot) return;
+        memset(by_slot + lb->by_slot_capacity, 0,
+               (capacity - lb->by_slot_capacity) * sizeof(LeaderNode*));
+        lb->by_slot = by_slot;
+        lb->by_slot_capacity = capacity;
+    }
+    
+    LeaderNode* node = lb->by_slot[slot];
+    if (node) {
+        node->challenges_completed = challenges_completed;
+        if (node->total_score == total_score && node->achieved_at == achieved_at) return;
+        leaderboard_unlink(lb, node);
+    } else {
+        int level = leaderboard_random_level(lb);
+        node = calloc(1, sizeof(LeaderNode) + level * sizeof(node->links[0]));
+        if (!node) return;
+        node->name = arena_strdup(&lb->names, name);
+        node->slot = slot;
+        node->level = level;
+        node->challenges_completed = challenges_completed;
+        lb->by_slot[slot] = node;
+    }
+    
+    node->total_score = total_score;
+    node->achieved_at = achieved_at;
+    leaderboard_link(lb, node);
+}
+
+void leaderboard_apply(Leaderboard* lb, int slot, const ScoreRecord* record) {
+    leaderboard_update(lb, slot, record->name, record->total_score,
+                       record->challenges_completed, record->updated_at);
+}
+
+// Node at 1-based rank, or NULL if out of range
+LeaderNode* leaderboard_at(const Leaderboard* lb, int rank) {
+    if (rank < 1 || rank > lb->count) return NULL;
+    
+    LeaderNode* x = lb->head;
+    int traversed = 0;
+    for(int i = lb->level - 1; i >= 0; i--) {
+        while (x->links[i].next && traversed + x->links[i].span <= rank) {
+            traversed += x->links[i].span;
+            x = x->links[i].next;
+        }
+        if (traversed == rank) return x;
+    }
+    return NULL;
+}
+
+// 1-based rank of the player stored at slot, or 0 if unranked
+int leaderboard_rank(const Leaderboard* lb, int slot) {
+    if (slot < 0 || slot >= lb->by_slot_capacity || !lb->by_slot[slot]) return 0;
+    
+    LeaderNode* node = lb->by_slot[slot];
+    LeaderNode* x = lb->head;
+    int rank = 0;
+    for(int i = lb->level - 1; i >= 0; i--) {
+        while (x->links[i].next && !leader_before(node, x->links[i].next)) {
+            rank += x->links[i].span;
+            x = x->links[i].next;
+        }
+        if (x == node) return rank;
+    }
+    return 0;
+}
+
+/*
+================================================================================
+    SCORE STATISTICS
+    Fenwick trees over the bounded score values, for rank and percentile
+================================================================================
+*/
+
+void histogram_init(ScoreHistogram* h, int max_value) {
+    memset(h, 0, sizeof(*h));
+    h->max_value = max_value;
+}
+
+// Add delta players at value (clamped to the histogram range)
+void histogram_add(ScoreHistogram* h, int value, int delta) {
+    if (value < 0) value = 0;
+    if (value > h->max_value) value = h->max_value;
+    for(int i = value + 1; i <= h->max_value + 1; i += i & -i) {
+        h->tree[i] += delta;
+    }
+    h->count += delta;
+}
+
+// Number of players with a score <= value
+int histogram_count_upto(const ScoreHistogram* h, int value) {
+    if (value < 0) return 0;
+    if (value > h->max_value) value = h->max_value;
+    int sum = 0;
+    for(int i = value + 1; i > 0; i -= i & -i) {
+        sum += h->tree[i];
+    }
+    return sum;
+}
+
+// Competition rank: 1 + number of players strictly above value
+int histogram_rank(const ScoreHistogram* h, int value) {
+    return h->count - histogram_count_upto(h, value) + 1;
+}
+
+// Percentile rank: players below plus half of the ties, in percent
+double histogram_percentile(const ScoreHistogram* h, int value) {
+    if (h->count == 0) return 0.0;
+    int below = histogram_count_upto(h, value - 1);
+    int equal = histogram_count_upto(h, value) - below;
+    return (below + equal / 2.0) * 100.0 / h->count;
+}
+
+// Most points a player can hold across every registered challenge
+int challenge_total_points() {
+    int total = 0;
+    for(int i = 0; i < CHALLENGE_COUNT; i++) total += CHALLENGES[i].max_points;
+    return total;
+}
+
+void score_stats_init() {
+    histogram_init(&total_histogram, challenge_total_points());
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        histogram_init(&challenge_histograms[i], CHALLENGES[i].max_points);
+    }
+}
+
+// Store a record's scores in its row of every column, growing them together
+void score_columns_set(ScoreColumns* table, int slot, const ScoreRecord* record) {
+    if (slot >= table->capacity) {
+        int capacity = table->capacity ? table->capacity : 1024;
+        while (capacity <= slot) capacity *= 2;
+        for(int i = 0; i < CHALLENGE_COUNT; i++) {
+            int32_t* column = realloc(table->columns[i], capacity * sizeof(int32_t));
+            if (!column) return;
+            memset(column + table->capacity, 0, (capacity - table->capacity) * sizeof(int32_t));
+            table->columns[i] = column;
+        }
+        table->capacity = capacity;
+    }
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        table->columns[i][slot] = record->scores[i];
+    }
+    if (slot >= table->rows) table->rows = slot + 1;
+}
+
+void score_columns_free(ScoreColumns* table) {
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        free(table->columns[i]);
+        table->columns[i] = NULL;
+    }
+    table->capacity = 0;
+    table->rows = 0;
+}
+
+// Players with a score in one challenge, their sum and the best score,
+// from a single pass over that challenge's column
+int score_column_summary(const ScoreColumns* table, ChallengeId challenge, long long* sum, int* best) {
+    const int32_t* column = table->columns[challenge];
+    int players = 0;
+    *sum = 0;
+    *best = 0;
+    for(int slot = 0; slot < table->rows; slot++) {
+        int32_t score = column[slot];
+        players += score > 0;
+        *sum += score;
+        if (score > *best) *best = score;
+    }
+    return players;
+}
+
+// The k best slots of one column, best first (earlier slots win ties);
+// returns how many were found
+int score_column_top(const ScoreColumns* table, ChallengeId challenge, int* slots, int k) {
+    const int32_t* column = table->columns[challenge];
+    int found = 0;
+    for(int slot = 0; slot < table->rows; slot++) {
+        int32_t score = column[slot];
+        if (score <= 0 || (found == k && score <= column[slots[k - 1]])) continue;
+        int i = found < k ? found++ : k - 1;
+        while (i > 0 && column[slots[i - 1]] < score) {
+            slots[i] = slots[i - 1];
+            i--;
+        }
+        slots[i] = slot;
+    }
+    return found;
+}
+
+// Count (delta = 1) or uncount (delta = -1) one player's record
+void score_stats_add(const ScoreRecord* record, int delta) {
+    histogram_add(&total_histogram, record->total_score, delta);
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        histogram_add(&challenge_histograms[i], record->scores[i], delta);
+    }
+}
+
+void on_score_record_changed(int slot, const ScoreRecord* previous, const ScoreRecord* record) {
+    if (previous) score_stats_add(previous, -1);
+    score_stats_add(record, 1);
+    // Rankings still to be built from the snapshot pick the record up then
+    if (rankings_pending) return;
+    score_columns_set(&score_columns, slot, record);
+    leaderboard_apply(&leaderboard, slot, record);
+}
+
+// Format n with thousands separators ("2,000,000")
+char* format_count(char* buf, long long n) {
+    char digits[32];
+    int len = sprintf(digits, "%lld", n < 0 ? -n : n);
+    char* out = buf;
+    if (n < 0) *out++ = '-';
+    for(int i = 0; i < len; i++) {
+        if (i > 0 && (len - i) % 3 == 0) *out++ = ',';
+        *out++ = digits[i];
+    }
+    *out = '\0';
+    return buf;
+}
+
+/*
+================================================================================
+    TIME WINDOWS
+    Per-day top-K buckets, merged on demand into daily, weekly and season boards
+================================================================================
+*/
+
+int64_t window_day(time_t now) {
+    return (int64_t)(now / SECONDS_PER_DAY);
+}
+
+long long window_offset(int64_t day) {
+    return (long long)sizeof(WindowHeader) + (day % WINDOW_DAYS) * (long long)sizeof(WindowBucket);
+}
+
+// Open (or create) the bucket file and load the ring; without it the
+// windows still work, but only for as long as the process runs
+int window_open(WindowBoards* boards, const char* path) {
+    memset(boards->buckets, 0, sizeof(boards->buckets));
+    for(int i = 0; i < WINDOW_DAYS; i++) boards->buckets[i].day = -1;
+    
+    boards->fd = file_open_rw(path);
+    if (boards->fd < 0) return 0;
+    
+    WindowHeader header;
+    if (file_size(boards->fd) < (long long)sizeof(WindowHeader)) {
+        header.magic = WINDOW_MAGIC;
+        header.version = WINDOW_VERSION;
+        header.bucket_size = sizeof(WindowBucket);
+        header.days = WINDOW_DAYS;
+        if (!file_pwrite(boards->fd, &header, sizeof(header), 0) ||
+            !file_pwrite(boards->fd, boards->buckets, sizeof(boards->buckets), sizeof(header))) {
+            goto fail;
+        }
+        return 1;
+    }
+    
+    if (!file_pread(boards->fd, &header, sizeof(header), 0) ||
+        header.magic != WINDOW_MAGIC || header.version != WINDOW_VERSION ||
+        header.bucket_size != sizeof(WindowBucket) || header.days != WINDOW_DAYS ||
+        !file_pread(boards->fd, boards->buckets, sizeof(boards->buckets), sizeof(header))) {
+        goto fail;
+    }
+    return 1;
+    
+fail:
+    file_close(boards->fd);
+    boards->fd = -1;
+    for(int i = 0; i < WINDOW_DAYS; i++) boards->buckets[i].day = -1;
+    return 0;
+}
+
+void window_close(WindowBoards* boards) {
+    if (boards->fd >= 0) file_close(boards->fd);
+    boards->fd = -1;
+}
+
+// The bucket for a day, cleared first if it still holds an older one
+WindowBucket* window_bucket(WindowBoards* boards, int64_t day) {
+    WindowBucket* bucket = &boards->buckets[day % WINDOW_DAYS];
+    if (bucket->day != day) {
+        memset(bucket, 0, sizeof(*bucket));
+        bucket->day = day;
+    }
+    return bucket;
+}
+
+// Count an attempt and keep it in the day's top-K when it makes the cut;
+// a player holds at most one entry per challenge and day, their best
+void window_record(WindowBoards* boards, ChallengeId challenge, int slot, int score, time_t now) {
+    int64_t day = window_day(now);
+    WindowBucket* bucket = window_bucket(boards, day);
+    WindowEntry* top = bucket->top[challenge];
+    int count = bucket->counts[challenge];
+    bucket->attempts[challenge]++;
+    
+    int i = 0;
+    while (i < count && top[i].slot != slot) i++;
+    int place = 1;
+    if (i == count) {
+        if (count < WINDOW_TOP_K) bucket->counts[challenge]++;
+        else if (score > top[count - 1].score) i = count - 1;
+        else place = 0;
+    } else if (score <= top[i].score) {
+        place = 0;
+    }
+    if (place) {
+        // Earlier entries keep their place on ties
+        while (i > 0 && top[i - 1].score < score) {
+            top[i] = top[i - 1];
+            i--;
+        }
+        top[i].slot = slot;
+        top[i].score = score;
+    }
+    
+    if (boards->fd >= 0) file_pwrite(boards->fd, bucket, sizeof(*bucket), window_offset(day));
+}
+
+// Order by slot, best score first within a slot
+int window_entry_compare(const void* a, const void* b) {
+    const WindowEntry* x = a;
+    const WindowEntry* y = b;
+    if (x->slot != y->slot) return x->slot < y->slot ? -1 : 1;
+    return (x->score < y->score) - (x->score > y->score);
+}
+
+// The k best players of the last `days` days (today included), best first,
+// merged from the daily top-Ks in O(days * WINDOW_TOP_K). A player's window
+// score is their best day; for k <= WINDOW_TOP_K the result is exact, since
+// anyone cut from a day's list had WINDOW_TOP_K players above them already.
+// Returns how many were found.
+int window_top(const WindowBoards* boards, ChallengeId challenge, int days, time_t now,
+               WindowEntry* out, int k, uint32_t* attempts) {
+    WindowEntry merged[WINDOW_DAYS * WINDOW_TOP_K];
+    int count = 0;
+    int64_t today = window_day(now);
+    if (days > WINDOW_DAYS) days = WINDOW_DAYS;
+    
+    *attempts = 0;
+    for(int d = 0; d < days; d++) {
+        const WindowBucket* bucket = &boards->buckets[(today - d) % WINDOW_DAYS];
+        if (bucket->day != today - d) continue;
+        *attempts += bucket->attempts[challenge];
+        memcpy(merged + count, bucket->top[challenge], bucket->counts[challenge] * sizeof(WindowEntry));
+        count += bucket->counts[challenge];
+    }
+    qsort(merged, count, sizeof(WindowEntry), window_entry_compare);
+    
+    int found = 0;
+    for(int i = 0; i < count; i++) {
+        if (i > 0 && merged[i].slot == merged[i - 1].slot) continue;
+        if (found == k && merged[i].score <= out[k - 1].score) continue;
+        int j = found < k ? found++ : k - 1;
+        while (j > 0 && out[j - 1].score < merged[i].score) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = merged[i];
+    }
+    return found;
+}
+
+/*
+================================================================================
+    ATTEMPT LOG
+    Append-only columnar segments of every finished attempt, scanned by
+    --attempt-stats through read-only mappings
+================================================================================
+*/
+
+const size_t ATTEMPT_COLUMN_WIDTH[ATTEMPT_COLUMN_COUNT] = { 8, 8, 4, 4, 4, 1 };
+
+// Byte offset of a cell; every column starts ATTEMPT_SEGMENT_ROWS cells
+// after the previous one
+long long attempt_cell_offset(AttemptColumn column, uint32_t row) {
+    long long offset = sizeof(AttemptSegmentHeader);
+    for(int i = 0; i < (int)column; i++) {
+        offset += (long long)ATTEMPT_COLUMN_WIDTH[i] * ATTEMPT_SEGMENT_ROWS;
+    }
+    return offset + (long long)ATTEMPT_COLUMN_WIDTH[column] * row;
+}
+
+long long attempt_segment_size() {
+    return attempt_cell_offset(ATTEMPT_COLUMN_COUNT - 1, ATTEMPT_SEGMENT_ROWS);
+}
+
+void attempt_segment_path(char* path, size_t size, int segment) {
+    snprintf(path, size, ATTEMPT_SEGMENT_FORMAT, segment);
+}
+
+// Open a segment for appends, creating it at full size; a full or foreign
+// segment is refused
+int attempt_segment_open(AttemptLog* log, int segment) {
+    char path[64];
+    attempt_segment_path(path, sizeof(path), segment);
+    int fd = file_open_rw(path);
+    if (fd < 0) return 0;
+    
+    AttemptSegmentHeader header;
+    if (file_size(fd) < (long long)sizeof(header)) {
+        header.magic = ATTEMPT_MAGIC;
+        header.version = ATTEMPT_VERSION;
+        header.capacity = ATTEMPT_SEGMENT_ROWS;
+        header.rows = 0;
+        if (!file_truncate(fd, attempt_segment_size()) ||
+            !file_pwrite(fd, &header, sizeof(header), 0)) {
+            file_close(fd);
+            return 0;
+        }
+    } else if (!file_pread(fd, &header, sizeof(header), 0) ||
+               header.magic != ATTEMPT_MAGIC || header.version != ATTEMPT_VERSION ||
+               header.capacity != ATTEMPT_SEGMENT_ROWS || header.rows >= header.capacity) {
+        file_close(fd);
+        return 0;
+    }
+    
+    log->fd = fd;
+    log->segment = segment;
+    log->rows = header.rows;
+    log->map = NULL;
+    #ifdef __linux__
+        // Allocate the blocks up front so a full disk fails here, not as a
+        // SIGBUS on a later store into the mapping
+        long long size = attempt_segment_size();
+        if (posix_fallocate(fd, 0, size) == 0) {
+            void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (map != MAP_FAILED) log->map = map;
+        }
+    #endif
+    return 1;
+}
+
+// Append to the last existing segment, or the one after it once that is full
+int attempt_log_open(AttemptLog* log) {
+    char path[64];
+    int last = 0;
+    for(;; last++) {
+        attempt_segment_path(path, sizeof(path), last + 1);
+        FILE* file = fopen(path, "rb");
+        if (!file) break;
+        fclose(file);
+    }
+    return attempt_segment_open(log, last) || attempt_segment_open(log, last + 1);
+}
+
+void attempt_log_close(AttemptLog* log) {
+    #ifndef _WIN32
+        if (log->map) munmap(log->map, attempt_segment_size());
+    #endif
+    if (log->fd >= 0) file_close(log->fd);
+    log->map = NULL;
+    log->fd = -1;
+}
+
+// Write one row's cells, then publish it by bumping the row count. Through
+// the mapping that is six stores and one release store, with no system call
+// on the session thread; without one it is seven pwrites.
+void attempt_log_append(AttemptLog* log, const AttemptRow* row) {
+    if (log->fd < 0 && !attempt_log_open(log)) return;
+    if (log->rows == ATTEMPT_SEGMENT_ROWS) {
+        int next = log->segment + 1;
+        attempt_log_close(log);
+        if (!attempt_segment_open(log, next)) return;
+    }
+    
+    const void* cells[ATTEMPT_COLUMN_COUNT] = {
+        &row->timestamp, &row->effort, &row->player, &row->duration_ms, &row->score, &row->challenge
+    };
+    uint32_t rows = log->rows + 1;
+    if (log->map) {
+        for(int i = 0; i < ATTEMPT_COLUMN_COUNT; i++) {
+            memcpy(log->map + attempt_cell_offset(i, log->rows), cells[i], ATTEMPT_COLUMN_WIDTH[i]);
+        }
+        // Readers map the same pages: the count must not pass the cells
+        AttemptSegmentHeader* header = (AttemptSegmentHeader*)log->map;
+        __atomic_store_n(&header->rows, rows, __ATOMIC_RELEASE);
+    } else {
+        for(int i = 0; i < ATTEMPT_COLUMN_COUNT; i++) {
+            if (!file_pwrite(log->fd, cells[i], ATTEMPT_COLUMN_WIDTH[i], attempt_cell_offset(i, log->rows))) return;
+        }
+        if (!file_pwrite(log->fd, &rows, sizeof(rows), offsetof(AttemptSegmentHeader, rows))) return;
+    }
+    log->rows = rows;
+    METRIC_ADD(METRIC_ATTEMPTS_LOGGED, 1);
+}
+
+int log_histogram_index(uint64_t value) {
+    if (value < (1u << LOG_HISTOGRAM_SUB_BITS)) return (int)value;
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - LOG_HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << LOG_HISTOGRAM_SUB_BITS) + (int)((value >> shift) & ((1u << LOG_HISTOGRAM_SUB_BITS) - 1));
+}
+
+// Middle of the values a bucket counts
+uint64_t log_histogram_value(int index) {
+    if (index < (1 << LOG_HISTOGRAM_SUB_BITS)) return (uint64_t)index;
+    int shift = (index >> LOG_HISTOGRAM_SUB_BITS) - 1;
+    uint64_t low = ((uint64_t)(index & ((1 << LOG_HISTOGRAM_SUB_BITS) - 1)) | (1u << LOG_HISTOGRAM_SUB_BITS)) << shift;
+    return low + ((1ull << shift) >> 1);
+}
+
+void log_histogram_add(LogHistogram* h, uint64_t value) {
+    h->buckets[log_histogram_index(value)]++;
+    h->count++;
+}
+
+// Value at quantile q (0 to 1) by nearest rank, within one bucket's width
+uint64_t log_histogram_quantile(const LogHistogram* h, double q) {
+    if (h->count == 0) return 0;
+    double exact = q * h->count;
+    uint64_t rank = (uint64_t)exact;
+    if (rank < exact || rank == 0) rank++;
+    uint64_t seen = 0;
+    for(int i = 0; i < LOG_HISTOGRAM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) return log_histogram_value(i);
+    }
+    return log_histogram_value(LOG_HISTOGRAM_BUCKETS - 1);
+}
+
+// Running totals of one challenge while scanning
+typedef struct {
+    uint64_t attempts;
+    uint64_t successes;
+    uint64_t score_sum;
+    uint64_t duration_sum;
+    uint64_t effort_sum;
+    LogHistogram durations;
+} AttemptSummary;
+
+// Fold one mapped segment into the summaries in a single pass that reads
+// five of the columns front to back
+void attempt_scan_segment(const char* base, uint32_t rows, int64_t since, AttemptSummary* summaries) {
+    const int64_t* timestamps = (const int64_t*)(base + attempt_cell_offset(ATTEMPT_TIMESTAMP, 0));
+    const uint64_t* efforts = (const uint64_t*)(base + attempt_cell_offset(ATTEMPT_EFFORT, 0));
+    const uint32_t* durations = (const uint32_t*)(base + attempt_cell_offset(ATTEMPT_DURATION, 0));
+    const int32_t* scores = (const int32_t*)(base + attempt_cell_offset(ATTEMPT_SCORE, 0));
+    const uint8_t* challenges = (const uint8_t*)(base + attempt_cell_offset(ATTEMPT_CHALLENGE, 0));
+    
+    for(uint32_t i = 0; i < rows; i++) {
+        if (timestamps[i] < since || challenges[i] >= CHALLENGE_COUNT) continue;
+        AttemptSummary* summary = &summaries[challenges[i]];
+        int32_t score = scores[i];
+        summary->attempts++;
+        summary->successes += score > 0;
+        summary->score_sum += score > 0 ? score : 0;
+        summary->duration_sum += durations[i];
+        summary->effort_sum += efforts[i];
+        log_histogram_add(&summary->durations, durations[i]);
+    }
+}
+
+// --attempt-stats [DAYS]: per-challenge analytics over every segment, or
+// over the attempts of the last DAYS days
+int attempt_stats_main(int argc, char** argv) {
+    int days = argc > 2 ? atoi(argv[2]) : 0;
+    if (days < 0) {
+        printf("Usage: %s --attempt-stats [DAYS]\n", argv[0]);
+        return 2;
+    }
+    
+    #ifdef _WIN32
+        printf("❌ Attempt analytics need memory-mapped files, not available on Windows.\n");
+        return 1;
+    #else
+        AttemptSummary* summaries = calloc(CHALLENGE_COUNT, sizeof(AttemptSummary));
+        if (!summaries) return 1;
+        int64_t since = days > 0 ? (int64_t)time(NULL) - (int64_t)days * SECONDS_PER_DAY : INT64_MIN;
+        long long size = attempt_segment_size();
+        uint64_t total = 0;
+        int segments = 0;
+        int64_t started = clock_now_ns();
+        
+        for(int segment = 0;; segment++) {
+            char path[64];
+            attempt_segment_path(path, sizeof(path), segment);
+            int fd = open(path, O_RDONLY);
+            if (fd < 0) break;
+            void* map = file_size(fd) == size ? mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+            close(fd);
+            if (map == MAP_FAILED) {
+                printf("⚠️  Skipping %s: not a complete segment.\n", path);
+                continue;
+            }
+            
+            const AttemptSegmentHeader* header = map;
+            if (header->magic == ATTEMPT_MAGIC && header->version == ATTEMPT_VERSION &&
+                header->capacity == ATTEMPT_SEGMENT_ROWS && header->rows <= header->capacity) {
+                madvise(map, size, MADV_SEQUENTIAL);
+                attempt_scan_segment(map, header->rows, since, summaries);
+                total += header->rows;
+                segments++;
+            } else {
+                printf("⚠️  Skipping %s: not an attempt segment.\n", path);
+            }
+            munmap(map, size);
+        }
+        double seconds = (double)(clock_now_ns() - started) / NS_PER_SECOND;
+        
+        char count[32];
+        printf("Scanned %s attempts in %d segment%s in %.2f s; ", format_count(count, (long long)total),
+               segments, segments == 1 ? "" : "s", seconds);
+        if (days > 0) printf("showing the last %d day%s\n\n", days, days == 1 ? "" : "s");
+        else printf("showing all time\n\n");
+        printf("%-12s %12s %8s %9s %9s %9s %9s %9s %12s\n", "Challenge", "Attempts", "Success",
+               "Avg score", "Avg s", "p50 s", "p90 s", "p99 s", "Avg effort");
+        for(int i = 0; i < CHALLENGE_COUNT; i++) {
+            const AttemptSummary* summary = &summaries[i];
+            uint64_t n = summary->attempts;
+            if (n == 0) {
+                printf("%-12s %12s\n", CHALLENGES[i].short_name, "0");
+                continue;
+            }
+            printf("%-12s %12s %7.1f%% %9.1f %9.1f %9.1f %9.1f %9.1f %12.1f\n",
+                   CHALLENGES[i].short_name, format_count(count, (long long)n),
+                   summary->successes * 100.0 / n,
+                   summary->successes ? (double)summary->score_sum / summary->successes : 0.0,
+                   summary->duration_sum / 1000.0 / n,
+                   log_histogram_quantile(&summary->durations, 0.50) / 1000.0,
+                   log_histogram_quantile(&summary->durations, 0.90) / 1000.0,
+                   log_histogram_quantile(&summary->durations, 0.99) / 1000.0,
+                   (double)summary->effort_sum / n);
+        }
+        free(summaries);
+        return 0;
+    #endif
+}
+
+/*
+================================================================================
+    SOLVE TIMES
+    Per-challenge log-bucketed histograms; merging two is adding their buckets
+================================================================================
+*/
+
+void log_histogram_merge(LogHistogram* into, const LogHistogram* from) {
+    for(int i = 0; i < LOG_HISTOGRAM_BUCKETS; i++) into->buckets[i] += from->buckets[i];
+    into->count += from->count;
+}
+
+void timing_merge(TimingStats* into, const TimingStats* from) {
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        log_histogram_merge(&into->solve[i], &from->solve[i]);
+        log_histogram_merge(&into->think[i], &from->think[i]);
+    }
+}
+
+void timing_record(LogHistogram* totals, LogHistogram* recent, int64_t ns) {
+    if (ns < 0) ns = 0;
+    log_histogram_add(totals, (uint64_t)ns);
+    log_histogram_add(recent, (uint64_t)ns);
+}
+
+// Read the saved histograms; returns 0 when the file is missing or foreign
+int timing_read(int fd, TimingStats* stats) {
+    TimingsHeader header;
+    return file_pread(fd, &header, sizeof(header), 0) &&
+           header.magic == TIMINGS_MAGIC && header.version == TIMINGS_VERSION &&
+           header.buckets == LOG_HISTOGRAM_BUCKETS && header.challenges == CHALLENGE_COUNT &&
+           file_pread(fd, stats, sizeof(*stats), sizeof(header));
+}
+
+void timing_load(const char* path) {
+    memset(&timing_totals, 0, sizeof(timing_totals));
+    memset(&timing_recent, 0, sizeof(timing_recent));
+    int fd = file_open_rw(path);
+    if (fd < 0) return;
+    if (!timing_read(fd, &timing_totals)) memset(&timing_totals, 0, sizeof(timing_totals));
+    file_close(fd);
+}
+
+// Add this process's timings to whatever the file holds now, so processes
+// that ran side by side each contribute theirs
+void timing_save(const char* path) {
+    TimingStats* merged = calloc(1, sizeof(TimingStats));
+    int fd = merged ? file_open_rw(path) : -1;
+    if (fd < 0) {
+        free(merged);
+        return;
+    }
+    if (!timing_read(fd, merged)) memset(merged, 0, sizeof(*merged));
+    timing_merge(merged, &timing_recent);
+    
+    TimingsHeader header = { TIMINGS_MAGIC, TIMINGS_VERSION, LOG_HISTOGRAM_BUCKETS, CHALLENGE_COUNT };
+    if (file_pwrite(fd, &header, sizeof(header), 0) &&
+        file_pwrite(fd, merged, sizeof(*merged), sizeof(header))) {
+        file_truncate(fd, sizeof(header) + sizeof(*merged));
+        memset(&timing_recent, 0, sizeof(timing_recent));
+    }
+    file_close(fd);
+    free(merged);
+}
+
+// "0.42 ms", "850 ms", "12.34 s", "4m 05s" or "2h 10m"
+char* format_duration(char* buf, size_t size, int64_t ns) {
+    if (ns < 10 * NS_PER_MS) snprintf(buf, size, "%.2f ms", (double)ns / NS_PER_MS);
+    else if (ns < NS_PER_SECOND) snprintf(buf, size, "%lld ms", (long long)(ns / NS_PER_MS));
+    else if (ns < 60 * NS_PER_SECOND) snprintf(buf, size, "%.2f s", (double)ns / NS_PER_SECOND);
+    else if (ns < 3600 * NS_PER_SECOND) {
+        long long seconds = ns / NS_PER_SECOND;
+        snprintf(buf, size, "%lldm %02llds", seconds / 60, seconds % 60);
+    } else {
+        long long minutes = ns / NS_PER_SECOND / 60;
+        snprintf(buf, size, "%lldh %02lldm", minutes / 60, minutes % 60);
+    }
+    return buf;
+}
+
+/*
+================================================================================
+    FILE HANDLING FUNCTIONS
+================================================================================
+*/
+
+// Load every registered name into the registry and open the log for
+// appends; with a snapshot, the names are looked up there instead
+int registry_load(UserRegistry* registry, const char* path) {
+    registry->base = registry->snapshot ? (int)registry->snapshot->header->users : 0;
+    FILE* file = registry->snapshot ? NULL : fopen(path, "r");
+    if (file) {
+        char line[MAX_NAME_LENGTH + 2];
+        while (fgets(line, sizeof(line), file)) {
+            line[strcspn(line, "\r\n")] = 0; // Remove newline
+            if (line[0]) {
+                name_index_put(&registry->names, line, (int)registry->names.count);
+            }
+        }
+        fclose(file);
+    }
+    
+    registry->log = fopen(path, "a");
+    return registry->log != NULL;
+}
+
+void registry_close(UserRegistry* registry) {
+    if (registry->log) fclose(registry->log);
+    registry->log = NULL;
+    name_index_free(&registry->names);
+}
+
+// Registration order of a user, or -1 if they are not registered
+int registry_find(const UserRegistry* registry, const char* username) {
+    int id = name_index_find(&registry->names, username);
+    if (id < 0 && registry->snapshot) {
+        const SnapshotRecord* entry = snapshot_find(registry->snapshot, username);
+        if (entry) id = entry->user;
+    }
+    return id;
+}
+
+// Check if a user is registered (a hash lookup, then a binary search of
+// the snapshot; no file access)
+int user_exists(const char* username) {
+    METRIC_ADD(METRIC_USER_LOOKUPS, 1);
+    return registry_find(&user_registry, username) >= 0;
+}
+
+// Register a new user and append them to the users log
+void add_user(const char* username) {
+    if (user_exists(username)) return;
+    name_index_put(&user_registry.names, username, user_registry.base + (int)user_registry.names.count);
+    
+    if (user_registry.log) {
+        fprintf(user_registry.log, "%s\n", username);
+        fflush(user_registry.log);
+    }
+}
+
+// Load player scores from the score store (an index or snapshot lookup,
+// at most one read)
+void load_player_scores(Player* player) {
+    TRACE_BEGIN(started);
+    ScoreRecord record;
+    int slot = store_load(&score_store, player->name, &record);
+    if (slot >= 0) {
+        player_from_record(player, &record);
+    }
+    METRIC_ADD(METRIC_SCORE_LOADS, 1);
+    TRACE_END(TRACE_SCORE_LOAD, started, slot);
+}
+
+// Save player scores: update the in-memory rankings now and queue the record
+// for the log writer, so the challenge screens never wait on the disk
+void save_player_scores(Player* player) {
+    ScoreRecord record, previous;
+    record_from_player(&record, player);
+    
+    int existed = store_load(&score_store, player->name, &previous) >= 0;
+    int slot = store_reserve(&score_store, player->name);
+    if (slot < 0) return;
+    
+    TRACE_BEGIN(started);
+    store_cache(&score_store, slot, &record);
+    wal_append(&score_wal, slot, &record);
+    on_score_record_changed(slot, existed ? &previous : NULL, &record);
+    METRIC_ADD(METRIC_SCORE_SAVES, 1);
+    TRACE_END(TRACE_SCORE_SAVE, started, slot);
+}
+
+/*
+================================================================================
+    SCORE SNAPSHOT
+    Every player sorted by name in one mapped file, so a restart neither
+    indexes the store nor reads the users log
+================================================================================
+*/
+
+// Size and modification time of a file; 0 if it cannot be stat'ed
+int file_stamp(const char* path, int64_t* size, int64_t* mtime_ns) {
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+    *size = (int64_t)st.st_size;
+    #ifdef __linux__
+        *mtime_ns = (int64_t)st.st_mtim.tv_sec * NS_PER_SECOND + st.st_mtim.tv_nsec;
+    #else
+        *mtime_ns = (int64_t)st.st_mtime * NS_PER_SECOND;
+    #endif
+    return 1;
+}
+
+// Map the snapshot if it still describes the store and the users log exactly
+int snapshot_open(ScoreSnapshot* snapshot, const char* path, const char* store_path, const char* users_path) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    
+    #ifdef _WIN32
+        (void)path; (void)store_path; (void)users_path;
+        return 0;
+    #else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return 0;
+        
+        long long size = file_size(fd);
+        if (size < (long long)sizeof(SnapshotHeader)) {
+            close(fd);
+            return 0;
+        }
+        void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) return 0;
+        
+        const SnapshotHeader* header = map;
+        uint64_t stride = header->index_stride;
+        int64_t store_size = -1, store_mtime = 0, users_size = -1, users_mtime = 0;
+        file_stamp(store_path, &store_size, &store_mtime);
+        file_stamp(users_path, &users_size, &users_mtime);
+        int valid = header->magic == SNAPSHOT_MAGIC &&
+                    header->version == SNAPSHOT_VERSION &&
+                    header->record_size == sizeof(SnapshotRecord) &&
+                    stride > 0 &&
+                    header->index_count == (header->count + stride - 1) / stride &&
+                    header->histograms_size == sizeof(ScoreHistogram) * (CHALLENGE_COUNT + 1) &&
+                    header->histograms_offset + header->histograms_size <= header->records_offset &&
+                    header->records_offset % sizeof(int64_t) == 0 &&
+                    header->records_offset + header->count * sizeof(SnapshotRecord) <= header->index_offset &&
+                    header->index_offset + header->index_count * MAX_NAME_LENGTH == (uint64_t)size &&
+                    header->store_records <= INT32_MAX && header->users <= INT32_MAX &&
+                    header->store_size == store_size && header->store_mtime_ns == store_mtime &&
+                    header->users_size == users_size && header->users_mtime_ns == users_mtime;
+        if (!valid) {
+            munmap(map, size);
+            return 0;
+        }
+        
+        snapshot->map = map;
+        snapshot->size = size;
+        snapshot->header = header;
+        snapshot->records = (const SnapshotRecord*)((const char*)map + header->records_offset);
+        snapshot->index = (const char (*)[MAX_NAME_LENGTH])((const char*)map + header->index_offset);
+        return 1;
+    #endif
+}
+
+void snapshot_close(ScoreSnapshot* snapshot) {
+    #ifndef _WIN32
+        if (snapshot->map) munmap(snapshot->map, snapshot->size);
+    #endif
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+// Binary search of the sparse index for the block that could hold name,
+// then of that block's records; nothing is parsed or allocated
+const SnapshotRecord* snapshot_find(const ScoreSnapshot* snapshot, const char* name) {
+    if (!snapshot->header || snapshot->header->index_count == 0) return NULL;
+    
+    // Last index entry <= name
+    size_t low = 0, high = snapshot->header->index_count;
+    while (high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        if (strncmp(snapshot->index[mid], name, MAX_NAME_LENGTH) <= 0) low = mid;
+        else high = mid;
+    }
+    
+    size_t stride = snapshot->header->index_stride;
+    size_t first = low * stride;
+    size_t last = first + stride < snapshot->header->count ? first + stride : snapshot->header->count;
+    while (first < last) {
+        size_t mid = first + (last - first) / 2;
+        int cmp = strncmp(snapshot->records[mid].record.name, name, MAX_NAME_LENGTH);
+        if (cmp == 0) return &snapshot->records[mid];
+        if (cmp < 0) first = mid + 1;
+        else last = mid;
+    }
+    return NULL;
+}
+
+// Take the score histograms from the snapshot instead of counting the store;
+// fails if the challenges' point ranges have changed since it was written
+int snapshot_restore_stats(const ScoreSnapshot* snapshot) {
+    const ScoreHistogram* saved = (const ScoreHistogram*)((const char*)snapshot->map + snapshot->header->histograms_offset);
+    if (saved[0].max_value != total_histogram.max_value) return 0;
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        if (saved[i + 1].max_value != challenge_histograms[i].max_value) return 0;
+    }
+    total_histogram = saved[0];
+    memcpy(challenge_histograms, saved + 1, sizeof(challenge_histograms));
+    return 1;
+}
+
+// Build the leaderboard and the score columns on first use after starting
+// from a snapshot: its records in order, with this run's changes on top
+void rankings_load() {
+    if (!rankings_pending) return;
+    rankings_pending = 0;
+    
+    const ScoreSnapshot* snapshot = score_store.snapshot;
+    ScoreRecord record;
+    for(uint64_t i = 0; snapshot && i < snapshot->header->count; i++) {
+        int slot = snapshot->records[i].slot;
+        if (slot < 0) continue;
+        const ScoreRecord* latest = slot < score_store.cache_capacity && score_store.cache[slot]
+                                  ? score_store.cache[slot] : &snapshot->records[i].record;
+        score_columns_set(&score_columns, slot, latest);
+        leaderboard_apply(&leaderboard, slot, latest);
+    }
+    // Players who scored for the first time since
+    int first_new = snapshot ? (int)snapshot->header->store_records : 0;
+    for(int slot = first_new; slot < score_store.record_count; slot++) {
+        if (!store_read(&score_store, slot, &record)) continue;
+        score_columns_set(&score_columns, slot, &record);
+        leaderboard_apply(&leaderboard, slot, &record);
+    }
+}
+
+int snapshot_list_push(SnapshotList* list, const ScoreRecord* record, int slot, int user) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        SnapshotRecord* records = realloc(list->records, capacity * sizeof(SnapshotRecord));
+        if (!records) return 0;
+        list->records = records;
+        list->capacity = capacity;
+    }
+    SnapshotRecord* entry = &list->records[list->count++];
+    memset(entry, 0, sizeof(*entry));
+    if (record) entry->record = *record;
+    entry->slot = slot;
+    entry->user = user;
+    return 1;
+}
+
+int snapshot_record_compare(const void* a, const void* b) {
+    return strncmp(((const SnapshotRecord*)a)->record.name,
+                   ((const SnapshotRecord*)b)->record.name, MAX_NAME_LENGTH);
+}
+
+// Everything that differs from the mapped snapshot (or everything, without
+// one), sorted by name with one entry per player
+int snapshot_collect_changes(SnapshotList* changes, ScoreStore* store, const UserRegistry* registry) {
+    const ScoreSnapshot* snapshot = store->snapshot;
+    int first_new = snapshot ? (int)snapshot->header->store_records : 0;
+    
+    // Records changed this run are cached; the rest were unchanged or are
+    // new, and the log has been checkpointed, so the store file is current
+    for(int slot = 0; slot < first_new && slot < store->cache_capacity; slot++) {
+        const ScoreRecord* record = store->cache[slot];
+        if (!record) continue;
+        const SnapshotRecord* entry = snapshot_find(snapshot, record->name);
+        if (entry && entry->slot == slot && memcmp(&entry->record, record, sizeof(*record)) == 0) continue;
+        if (!snapshot_list_push(changes, record, slot, registry_find(registry, record->name))) return 0;
+    }
+    ScoreRecord* batch = malloc(STORE_READ_BATCH * sizeof(ScoreRecord));
+    if (!batch) return 0;
+    for(int first = first_new; first < store->record_count; first += STORE_READ_BATCH) {
+        int n = store->record_count - first < STORE_READ_BATCH ? store->record_count - first : STORE_READ_BATCH;
+        if (!file_pread(store->fd, batch, n * sizeof(ScoreRecord), store_offset(first))) {
+            free(batch);
+            return 0;
+        }
+        for(int i = 0; i < n; i++) {
+            batch[i].name[MAX_NAME_LENGTH - 1] = '\0';
+            if (!batch[i].name[0]) continue;
+            if (!snapshot_list_push(changes, &batch[i], first + i, registry_find(registry, batch[i].name))) {
+                free(batch);
+                return 0;
+            }
+        }
+    }
+    free(batch);
+    
+    // Users registered since, with their scores if they have any
+    for(size_t i = 0; i < registry->names.capacity; i++) {
+        const NameIndexEntry* user = &registry->names.entries[i];
+        if (!user->name) continue;
+        ScoreRecord record;
+        memset(&record, 0, sizeof(record));
+        int slot = store_load(store, user->name, &record);
+        if (slot < 0) {
+            memset(&record, 0, sizeof(record));
+            strncpy(record.name, user->name, MAX_NAME_LENGTH - 1);
+        }
+        if (!snapshot_list_push(changes, &record, slot, user->value)) return 0;
+    }
+    
+    qsort(changes->records, changes->count, sizeof(SnapshotRecord), snapshot_record_compare);
+    size_t kept = 0;
+    for(size_t i = 0; i < changes->count; i++) {
+        if (kept > 0 && snapshot_record_compare(&changes->records[kept - 1], &changes->records[i]) == 0) {
+            SnapshotRecord* entry = &changes->records[kept - 1];
+            if (changes->records[i].slot >= 0) {
+                entry->record = changes->records[i].record;
+                entry->slot = changes->records[i].slot;
+            }
+            if (changes->records[i].user >= 0) entry->user = changes->records[i].user;
+            continue;
+        }
+        changes->records[kept++] = changes->records[i];
+    }
+    changes->count = kept;
+    return 1;
+}
+
+// Write a new snapshot next to the old one and rename it into place: the
+// old records merged with this run's changes, then every
+// SNAPSHOT_INDEX_STRIDE-th name. Called once the log has been closed.
+int snapshot_save(const char* path, const char* store_path, const char* users_path,
+                  ScoreStore* store, const UserRegistry* registry) {
+    #ifdef _WIN32
+        // Never read back without mmap
+        (void)path; (void)store_path; (void)users_path; (void)store; (void)registry;
+        return 1;
+    #else
+        if (store->fd < 0 || !registry->log) return 0;
+        
+        SnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        if (!file_stamp(store_path, &header.store_size, &header.store_mtime_ns) ||
+            !file_stamp(users_path, &header.users_size, &header.users_mtime_ns)) {
+            return 0;
+        }
+        
+        SnapshotList changes = { NULL, 0, 0 };
+        if (!snapshot_collect_changes(&changes, store, registry)) {
+            free(changes.records);
+            return 0;
+        }
+        const ScoreSnapshot* old = store->snapshot;
+        if (old && changes.count == 0 &&
+            old->header->store_size == header.store_size && old->header->store_mtime_ns == header.store_mtime_ns &&
+            old->header->users_size == header.users_size && old->header->users_mtime_ns == header.users_mtime_ns) {
+            free(changes.records);
+            return 1;
+        }
+        
+        char tmp_path[256];
+        snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+        FILE* file = fopen(tmp_path, "wb");
+        if (!file) {
+            free(changes.records);
+            return 0;
+        }
+        static char buffer[1 << 16];
+        setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+        
+        header.magic = SNAPSHOT_MAGIC;
+        header.version = SNAPSHOT_VERSION;
+        header.record_size = sizeof(SnapshotRecord);
+        header.index_stride = SNAPSHOT_INDEX_STRIDE;
+        header.store_records = store->record_count;
+        header.users = registry->base + registry->names.count;
+        header.histograms_offset = sizeof(header);
+        header.histograms_size = sizeof(ScoreHistogram) * (CHALLENGE_COUNT + 1);
+        header.records_offset = header.histograms_offset + header.histograms_size;
+        
+        int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(&total_histogram, sizeof(ScoreHistogram), 1, file) == 1 &&
+                 fwrite(challenge_histograms, sizeof(ScoreHistogram), CHALLENGE_COUNT, file) == CHALLENGE_COUNT;
+        
+        // Merge the two sorted runs; a change replaces the old entry
+        size_t index_capacity = 0;
+        char (*index)[MAX_NAME_LENGTH] = NULL;
+        uint64_t old_count = old ? old->header->count : 0;
+        uint64_t i = 0, j = 0;
+        while (ok && (i < old_count || j < changes.count)) {
+            const SnapshotRecord* entry;
+            int cmp = i == old_count ? 1 : j == changes.count ? -1 :
+                      snapshot_record_compare(&old->records[i], &changes.records[j]);
+            if (cmp < 0) entry = &old->records[i++];
+            else {
+                entry = &changes.records[j++];
+                if (cmp == 0) i++;
+            }
+            if (header.count % SNAPSHOT_INDEX_STRIDE == 0) {
+                if (header.index_count == index_capacity) {
+                    index_capacity = index_capacity ? index_capacity * 2 : 1024;
+                    char (*grown)[MAX_NAME_LENGTH] = realloc(index, index_capacity * MAX_NAME_LENGTH);
+                    if (!grown) {
+                        ok = 0;
+                        break;
+                    }
+                    index = grown;
+                }
+                memcpy(index[header.index_count++], entry->record.name, MAX_NAME_LENGTH);
+            }
+            ok = fwrite(entry, sizeof(*entry), 1, file) == 1;
+            header.count++;
+        }
+        free(changes.records);
+        
+        header.index_offset = header.records_offset + header.count * sizeof(SnapshotRecord);
+        ok = ok && fwrite(index, MAX_NAME_LENGTH, header.index_count, file) == header.index_count;
+        free(index);
+        ok = ok && fflush(file) == 0 &&
+             file_pwrite(fileno(file), &header, sizeof(header), 0) &&
+             file_sync(fileno(file));
+        ok = fclose(file) == 0 && ok;
+        
+        if (!ok || rename(tmp_path, path) != 0) {
+            unlink(tmp_path);
+            return 0;
+        }
+        return 1;
+    #endif
+}
+
+/*
+================================================================================
+    USER MANAGEMENT FUNCTIONS
+================================================================================
+*/
+
+// Initialize a new player with zero scores
+void initialize_player(Player* player, const char* username) {
+    strcpy(player->name, username);
+    memset(player->scores, 0, sizeof(player->scores));
+    player->total_score = 0;
+    player->challenges_completed = 0;
+}
+
+// Print global rank and per-challenge percentiles for a returning player
+void display_rank_summary(Session* s) {
+    if (total_histogram.count == 0) return;
+    
+    Player* player = &s->player;
+    char rank[32], count[32];
+    session_printf(s, "   • Global Rank: #%s of %s\n",
+           format_count(rank, histogram_rank(&total_histogram, player->total_score)),
+           format_count(count, total_histogram.count));
+    session_puts(s, "   • Percentiles:");
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        session_printf(s, "%s %s %.0f%%", i ? " |" : "", CHALLENGES[i].short_name,
+               histogram_percentile(&challenge_histograms[i], player->scores[i]));
+    }
+    session_puts(s, "\n");
+}
+
+// Start timing an attempt once its puzzle is on screen
+void challenge_begin(Session* s) {
+    s->attempt_started = clock_now_ns();
+    s->last_input = s->attempt_started;
+}
+
+// Time since the puzzle was dealt
+int64_t challenge_elapsed_ns(const Session* s) {
+    return clock_now_ns() - s->attempt_started;
+}
+
+// Log a finished attempt (score 0 when it failed or was skipped) with its
+// effort: guesses, steps, moves, or the distance left to the target. A
+// success is timed into the solve histograms, a result that beats the
+// player's best is saved, and every success counts towards the
+// time-windowed boards
+void challenge_record_attempt(Session* s, ChallengeId challenge, int score, uint64_t effort) {
+    Player* player = &s->player;
+    int64_t elapsed_ns = challenge_elapsed_ns(s);
+    int64_t elapsed = elapsed_ns / NS_PER_MS;
+    AttemptRow row = {
+        .timestamp = (int64_t)time(NULL),
+        .effort = effort,
+        .player = registry_find(&user_registry, player->name),
+        .duration_ms = elapsed < 0 ? 0 : elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed,
+        .score = score,
+        .challenge = (uint8_t)challenge
+    };
+    attempt_log_append(&attempt_log, &row);
+    if (score <= 0) return;
+    
+    char duration[32];
+    timing_record(&timing_totals.solve[challenge], &timing_recent.solve[challenge], elapsed_ns);
+    session_printf(s, "⏱️  Time taken: %s\n", format_duration(duration, sizeof(duration), elapsed_ns));
+    
+    if (player->scores[challenge] == 0) {
+        player->challenges_completed++;
+    }
+    
+    if (score > player->scores[challenge]) {
+        player->total_score = player->total_score - player->scores[challenge] + score;
+        player->scores[challenge] = score;
+        save_player_scores(player);
+        session_printf(s, "🏆 New personal best!\n");
+    }
+    
+    int slot = store_find(&score_store, player->name);
+    if (slot >= 0) window_record(&window_boards, challenge, slot, score, time(NULL));
+}
+
+// Show the login screen and wait for a name
+void login_start(Session* s) {
+    clear_screen(s);
+    display_banner(s);
+    
+    session_printf(s, "Enter your name: ");
+    s->screen = SCREEN_LOGIN;
+}
+
+// Handle user login or registration
+void login_input(Session* s, const char* line) {
+    char username[MAX_NAME_LENGTH];
+    snprintf(username, sizeof(username), "%s", line);
+    
+    if (username[0] == '\0') {
+        session_printf(s, "Enter your name: ");
+        return;
+    }
+    
+    if (user_exists(username)) {
+        initialize_player(&s->player, username);
+        load_player_scores(&s->player);
+        
+        session_printf(s, "\n╔═══════════════════════════════════════════════╗\n");
+        int padding = 27 - strlen(s->player.name);
+        session_printf(s, "║  Welcome back, %s!%*s║\n", s->player.name, padding > 0 ? padding : 0, "");
+        session_printf(s, "╚═══════════════════════════════════════════════╝\n");
+        session_printf(s, "\n📊 Your Statistics:\n");
+        session_printf(s, "   • Total Score: %d points\n", s->player.total_score);
+        session_printf(s, "   • Challenges Completed: %d/%d\n", s->player.challenges_completed, CHALLENGE_COUNT);
+        display_rank_summary(s);
+    } else {
+        add_user(username);
+        initialize_player(&s->player, username);
+        
+        session_printf(s, "\n╔═══════════════════════════════════════════════╗\n");
+        int padding = 32 - strlen(s->player.name);
+        session_printf(s, "║  Welcome, %s!%*s║\n", s->player.name, padding > 0 ? padding : 0, "");
+        session_printf(s, "║  Let's start your coding journey! 🚀           ║\n");
+        session_printf(s, "╚════════════════════════════════════════════════╝\n");
+    }
+    
+    pause_screen(s);
+}
+
+/*
+================================================================================
+    COMPTE EST BON SOLVER
+    Every value reachable from each subset of the numbers, built bottom-up
+================================================================================
+*/
+
+uint32_t solver_hash(int32_t value) {
+    return (uint32_t)value * 2654435761u;
+}
+
+// Add a value to a subset's set. The first way of reaching it is kept for
+// printing; later ones only add to its derivation count.
+void solver_set_insert(SolverSet* set, int32_t value, int32_t left, uint16_t left_mask, char op, uint64_t ways) {
+    if ((set->count + 1) * 4 > set->capacity * 3) {
+        size_t capacity = set->capacity ? set->capacity * 2 : 16;
+        SolverEntry* slots = calloc(capacity, sizeof(SolverEntry));
+        if (!slots) return;
+        for(size_t i = 0; i < set->capacity; i++) {
+            if (set->slots[i].value == 0) continue;
+            size_t j = solver_hash(set->slots[i].value) & (capacity - 1);
+            while (slots[j].value != 0) j = (j + 1) & (capacity - 1);
+            slots[j] = set->slots[i];
+        }
+        free(set->slots);
+        set->slots = slots;
+        set->capacity = capacity;
+    }
+    
+    size_t i = solver_hash(value) & (set->capacity - 1);
+    if (ways > UINT32_MAX) ways = UINT32_MAX;
+    while (set->slots[i].value != 0) {
+        if (set->slots[i].value == value) {
+            uint64_t total = set->slots[i].ways + ways;
+            set->slots[i].ways = total > UINT32_MAX ? UINT32_MAX : (uint32_t)total;
+            return;
+        }
+        i = (i + 1) & (set->capacity - 1);
+    }
+    set->slots[i] = (SolverEntry){ value, left, (uint32_t)ways, left_mask, op };
+    set->count++;
+}
+
+const SolverEntry* solver_set_find(const SolverSet* set, int32_t value) {
+    if (set->capacity == 0) return NULL;
+    size_t i = solver_hash(value) & (set->capacity - 1);
+    while (set->slots[i].value != 0) {
+        if (set->slots[i].value == value) return &set->slots[i];
+        i = (i + 1) & (set->capacity - 1);
+    }
+    return NULL;
+}
+
+// Combine every split of mask into two non-empty halves. Only positive
+// integer results are kept, and operations that just give back one of
+// the operands (x*1, x/1, 2x-x, x²/x) are skipped.
+void solver_fill(CompteBonSolver* solver, uint16_t mask) {
+    SolverSet* set = &solver->sets[mask];
+    for(uint16_t sub = (mask - 1) & mask; sub; sub = (sub - 1) & mask) {
+        uint16_t other = mask ^ sub;
+        if (sub < other) continue; // Each unordered split once
+        
+        const SolverSet* left = &solver->sets[sub];
+        const SolverSet* right = &solver->sets[other];
+        for(size_t i = 0; i < left->capacity; i++) {
+            int64_t x = left->slots[i].value;
+            if (x == 0) continue;
+            for(size_t j = 0; j < right->capacity; j++) {
+                int64_t y = right->slots[j].value;
+                if (y == 0) continue;
+                
+                int64_t a = x >= y ? x : y;
+                int64_t b = x >= y ? y : x;
+                uint16_t a_mask = x >= y ? sub : other;
+                uint64_t ways = (uint64_t)left->slots[i].ways * right->slots[j].ways;
+                
+                if (a + b <= SOLVER_VALUE_LIMIT) solver_set_insert(set, a + b, a, a_mask, '+', ways);
+                if (b > 1 && a * b <= SOLVER_VALUE_LIMIT) solver_set_insert(set, a * b, a, a_mask, '*', ways);
+                if (a > b && a - b != b) solver_set_insert(set, a - b, a, a_mask, '-', ways);
+                if (b > 1 && a % b == 0 && a / b != b) solver_set_insert(set, a / b, a, a_mask, '/', ways);
+            }
+        }
+    }
+}
+
+#ifndef _WIN32
+typedef struct {
+    CompteBonSolver* solver;
+    const uint16_t* masks;
+    int count;
+    int next;
+    pthread_mutex_t lock;
+} SolverLevel;
+
+// Worker: take masks of the current level until none are left
+void* solver_worker(void* arg) {
+    SolverLevel* level = arg;
+    for(;;) {
+        pthread_mutex_lock(&level->lock);
+        int i = level->next++;
+        pthread_mutex_unlock(&level->lock);
+        if (i >= level->count) return NULL;
+        solver_fill(level->solver, level->masks[i]);
+    }
+}
+#endif
+
+// Fill the sets level by level. Subsets of the same size only read smaller
+// ones, so with enough numbers each level is split across threads.
+void solver_run(CompteBonSolver* solver) {
+    int full = (1 << solver->count) - 1;
+    uint16_t* masks = malloc(sizeof(uint16_t) * (full + 1));
+    if (!masks) return;
+    
+    #ifndef _WIN32
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int threads = cpus > SOLVER_MAX_THREADS ? SOLVER_MAX_THREADS : (int)cpus;
+    #endif
+    
+    for(int size = 2; size <= solver->count; size++) {
+        int count = 0;
+        for(int mask = 1; mask <= full; mask++) {
+            if (__builtin_popcount(mask) == size) masks[count++] = mask;
+        }
+        
+        #ifndef _WIN32
+            if (solver->count >= SOLVER_PARALLEL_MIN && threads > 1 && count > 1) {
+                SolverLevel level = { solver, masks, count, 0, PTHREAD_MUTEX_INITIALIZER };
+                pthread_t workers[SOLVER_MAX_THREADS];
+                int started = 0;
+                while (started < threads && started < count &&
+                       pthread_create(&workers[started], NULL, solver_worker, &level) == 0) {
+                    started++;
+                }
+                solver_worker(&level); // Also covers a failed pthread_create
+                for(int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+                pthread_mutex_destroy(&level.lock);
+                continue;
+            }
+        #endif
+        
+        for(int i = 0; i < count; i++) solver_fill(solver, masks[i]);
+    }
+    free(masks);
+}
+
+// Every value reachable from a draw, per subset
+int solver_build(CompteBonSolver* solver, const int* numbers, int count) {
+    memset(solver, 0, sizeof(*solver));
+    if (count < 1 || count > SOLVER_MAX_NUMBERS) return 0;
+    solver->count = count;
+    
+    solver->sets = calloc(1 << count, sizeof(SolverSet));
+    if (!solver->sets) return 0;
+    
+    for(int i = 0; i < count; i++) {
+        solver_set_insert(&solver->sets[1 << i], numbers[i], 0, 0, 0, 1);
+    }
+    solver_run(solver);
+    return 1;
+}
+
+// How many ways reach target and the fewest operations needed; 0 if it
+// cannot be reached
+int solver_target_stats(const CompteBonSolver* solver, int target, uint32_t* solutions, int* depth) {
+    uint64_t total = 0;
+    *depth = solver->count;
+    for(int mask = 1; mask < (1 << solver->count); mask++) {
+        const SolverEntry* entry = solver_set_find(&solver->sets[mask], target);
+        if (!entry) continue;
+        total += entry->ways;
+        int ops = __builtin_popcount(mask) - 1;
+        if (ops < *depth) *depth = ops;
+    }
+    *solutions = total > UINT32_MAX ? UINT32_MAX : (uint32_t)total;
+    return total > 0;
+}
+
+// Solve a draw: every reachable value and the one closest to target
+int solver_solve(CompteBonSolver* solver, const int* numbers, int count, int target) {
+    if (!solver_build(solver, numbers, count)) return 0;
+    solver->target = target;
+    int full = (1 << count) - 1;
+    
+    // Closest value over all subsets, preferring fewer numbers
+    solver->best_mask = 0;
+    for(int size = 1; size <= count && (solver->best_mask == 0 || solver->best_distance != 0); size++) {
+        for(int mask = 1; mask <= full; mask++) {
+            if (__builtin_popcount(mask) != size) continue;
+            const SolverSet* set = &solver->sets[mask];
+            for(size_t i = 0; i < set->capacity; i++) {
+                int32_t value = set->slots[i].value;
+                if (value == 0) continue;
+                int64_t distance = value > target ? (int64_t)value - target : (int64_t)target - value;
+                if (solver->best_mask == 0 || distance < solver->best_distance) {
+                    solver->best = value;
+                    solver->best_mask = mask;
+                    solver->best_distance = distance;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// Write how value is reached from mask's numbers, e.g. "(25 * 4) - 3"
+void solver_format(const CompteBonSolver* solver, uint16_t mask, int32_t value, int nested, char* out, size_t size) {
+    const SolverEntry* entry = solver_set_find(&solver->sets[mask], value);
+    if (!entry || entry->left_mask == 0) {
+        snprintf(out, size, "%d", value);
+        return;
+    }
+    
+    int32_t left = entry->left;
+    int32_t right = 0;
+    switch (entry->op) {
+        case '+': right = value - left; break;
+        case '-': right = left - value; break;
+        case '*': right = value / left; break;
+        case '/': right = left / value; break;
+    }
+    
+    char a[SOLVER_EXPRESSION_MAX], b[SOLVER_EXPRESSION_MAX];
+    solver_format(solver, entry->left_mask, left, 1, a, sizeof(a));
+    solver_format(solver, mask ^ entry->left_mask, right, 1, b, sizeof(b));
+    snprintf(out, size, nested ? "(%s %c %s)" : "%s %c %s", a, entry->op, b);
+}
+
+// The expression reaching the best value
+void solver_solution(const CompteBonSolver* solver, char* out, size_t size) {
+    solver_format(solver, solver->best_mask, solver->best, 0, out, size);
+}
+
+void solver_free(CompteBonSolver* solver) {
+    if (!solver->sets) return;
+    for(int mask = 0; mask < (1 << solver->count); mask++) {
+        free(solver->sets[mask].slots);
+    }
+    free(solver->sets);
+    solver->sets = NULL;
+}
+
+/*
+================================================================================
+    PUZZLE CATALOG
+    Every Compte est Bon draw solved offline, grouped by difficulty tier
+================================================================================
+*/
+
+const char* CATALOG_TIER_NAMES[CATALOG_TIERS] = { "Easy", "Medium", "Hard", "Expert" };
+
+// Tier from the fewest operations needed, one tier up for rare targets
+int catalog_tier(int depth, uint32_t solutions) {
+    int tier = depth <= 2 ? 0 : depth - 2;
+    if (solutions <= CATALOG_RARE_SOLUTIONS) tier++;
+    return tier < CATALOG_TIERS ? tier : CATALOG_TIERS - 1;
+}
+
+// Order by tier, then target, then numbers; the tier ranges are what
+// catalog_pick indexes into
+int catalog_compare(const void* a, const void* b) {
+    const CatalogPuzzle* x = a;
+    const CatalogPuzzle* y = b;
+    if (x->tier != y->tier) return x->tier - y->tier;
+    if (x->target != y->target) return x->target - y->target;
+    return memcmp(x->numbers, y->numbers, sizeof(x->numbers));
+}
+
+// Solve one draw and keep a few targets of each tier. The picks are seeded
+// by the draw so two builds produce the same file.
+void catalog_solve_draw(CatalogBuild* build, int draw) {
+    CatalogPuzzle* out = &build->puzzles[(size_t)draw * CATALOG_TIERS * CATALOG_TARGETS_PER_TIER];
+    const uint8_t* numbers = build->draws[draw];
+    int values[COMPTE_BON_NUMBERS];
+    for(int i = 0; i < COMPTE_BON_NUMBERS; i++) values[i] = numbers[i];
+    
+    CompteBonSolver solver;
+    if (!solver_build(&solver, values, COMPTE_BON_NUMBERS)) return;
+    
+    int seen[CATALOG_TIERS] = { 0 };
+    uint32_t seed = 2166136261u ^ (uint32_t)draw * 16777619u;
+    for(int target = CATALOG_TARGET_MIN; target <= CATALOG_TARGET_MAX; target++) {
+        uint32_t solutions;
+        int depth;
+        if (!solver_target_stats(&solver, target, &solutions, &depth)) continue;
+        
+        // Reservoir sampling keeps each tier's picks uniform over its targets
+        int tier = catalog_tier(depth, solutions);
+        int slot = seen[tier]++;
+        if (slot >= CATALOG_TARGETS_PER_TIER) {
+            seed = seed * 1103515245u + 12345u;
+            slot = (seed >> 8) % (slot + 1);
+            if (slot >= CATALOG_TARGETS_PER_TIER) continue;
+        }
+        
+        CatalogPuzzle* puzzle = &out[tier * CATALOG_TARGETS_PER_TIER + slot];
+        memcpy(puzzle->numbers, numbers, sizeof(puzzle->numbers));
+        puzzle->target = target;
+        puzzle->solutions = solutions;
+        puzzle->depth = depth;
+        puzzle->tier = tier;
+    }
+    solver_free(&solver);
+}
+
+#ifndef _WIN32
+// Worker: take draws until none are left
+void* catalog_worker(void* arg) {
+    CatalogBuild* build = arg;
+    for(;;) {
+        pthread_mutex_lock(&build->lock);
+        int draw = build->next++;
+        pthread_mutex_unlock(&build->lock);
+        if (draw >= build->draw_count) return NULL;
+        catalog_solve_draw(build, draw);
+    }
+}
+#endif
+
+// Enumerate every draw the game can deal, solve them on all cores and
+// write the sorted catalog. Returns 0 on success, for use as exit status.
+int catalog_build(const char* path) {
+    CatalogBuild build;
+    memset(&build, 0, sizeof(build));
+    
+    // Same ranges as the live draw; the two 1-9 numbers are unordered
+    int count = 0;
+    for(int a = 1; a <= 9; a++)
+    for(int b = a; b <= 9; b++)
+    for(int c = 2; c <= 10; c++)
+    for(int d = 5; d <= 20; d += 5)
+    for(int e = 20; e <= 50; e += 10)
+    for(int f = 25; f <= 100; f += 25) {
+        count++;
+    }
+    
+    size_t per_draw = CATALOG_TIERS * CATALOG_TARGETS_PER_TIER;
+    build.draws = malloc(sizeof(*build.draws) * count);
+    build.puzzles = calloc((size_t)count * per_draw, sizeof(CatalogPuzzle));
+    if (!build.draws || !build.puzzles) {
+        free(build.draws);
+        free(build.puzzles);
+        printf("❌ Out of memory.\n");
+        return 1;
+    }
+    
+    for(int a = 1; a <= 9; a++)
+    for(int b = a; b <= 9; b++)
+    for(int c = 2; c <= 10; c++)
+    for(int d = 5; d <= 20; d += 5)
+    for(int e = 20; e <= 50; e += 10)
+    for(int f = 25; f <= 100; f += 25) {
+        uint8_t* draw = build.draws[build.draw_count++];
+        draw[0] = a; draw[1] = b; draw[2] = c;
+        draw[3] = d; draw[4] = e; draw[5] = f;
+    }
+    
+    printf("🧮 Solving %d draws...\n", count);
+    fflush(stdout);
+    time_t started = time(NULL);
+    
+    #ifndef _WIN32
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int threads = cpus > SOLVER_MAX_THREADS ? SOLVER_MAX_THREADS : (int)cpus;
+        pthread_t workers[SOLVER_MAX_THREADS];
+        int started_threads = 0;
+        pthread_mutex_init(&build.lock, NULL);
+        while (started_threads < threads - 1 &&
+               pthread_create(&workers[started_threads], NULL, catalog_worker, &build) == 0) {
+            started_threads++;
+        }
+        catalog_worker(&build);
+        for(int i = 0; i < started_threads; i++) pthread_join(workers[i], NULL);
+        pthread_mutex_destroy(&build.lock);
+    #else
+        for(int draw = 0; draw < count; draw++) catalog_solve_draw(&build, draw);
+    #endif
+    
+    // Squeeze out unused slots, then sort into tier ranges
+    size_t kept = 0;
+    for(size_t i = 0; i < (size_t)count * per_draw; i++) {
+        if (build.puzzles[i].target != 0) build.puzzles[kept++] = build.puzzles[i];
+    }
+    qsort(build.puzzles, kept, sizeof(CatalogPuzzle), catalog_compare);
+    
+    CatalogHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CATALOG_MAGIC;
+    header.version = CATALOG_VERSION;
+    header.record_size = sizeof(CatalogPuzzle);
+    header.count = kept;
+    for(size_t i = 0; i < kept; i++) {
+        header.tier_count[build.puzzles[i].tier]++;
+    }
+    for(int tier = 1; tier < CATALOG_TIERS; tier++) {
+        header.tier_offset[tier] = header.tier_offset[tier - 1] + header.tier_count[tier - 1];
+    }
+    
+    // Write next to the target and rename, so a running game never maps a
+    // half-written file
+    char temp_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE* file = fopen(temp_path, "wb");
+    int ok = file != NULL;
+    if (ok) {
+        ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(build.puzzles, sizeof(CatalogPuzzle), kept, file) == kept;
+        ok = (fclose(file) == 0) && ok;
+        ok = ok && rename(temp_path, path) == 0;
+        if (!ok) remove(temp_path);
+    }
+    
+    if (ok) {
+        printf("📚 Wrote %zu puzzles to %s in %d seconds:", kept, path, (int)difftime(time(NULL), started));
+        for(int tier = 0; tier < CATALOG_TIERS; tier++) {
+            printf(" %s %u%s", CATALOG_TIER_NAMES[tier], header.tier_count[tier], tier < CATALOG_TIERS - 1 ? "," : "\n");
+        }
+    } else {
+        printf("❌ Could not write %s.\n", path);
+    }
+    
+    free(build.draws);
+    free(build.puzzles);
+    return ok ? 0 : 1;
+}
+
+// Map a catalog built by catalog_build. Nothing is parsed: the header is
+// checked and the records are used in place.
+int catalog_open(PuzzleCatalog* catalog, const char* path) {
+    memset(catalog, 0, sizeof(*catalog));
+    
+    #ifdef _WIN32
+        (void)path;
+        return 0;
+    #else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return 0;
+        
+        long long size = file_size(fd);
+        if (size < (long long)sizeof(CatalogHeader)) {
+            close(fd);
+            return 0;
+        }
+        void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) return 0;
+        
+        const CatalogHeader* header = map;
+        int valid = header->magic == CATALOG_MAGIC &&
+                    header->version == CATALOG_VERSION &&
+                    header->record_size == sizeof(CatalogPuzzle) &&
+                    size == (long long)(sizeof(CatalogHeader) + (size_t)header->count * sizeof(CatalogPuzzle));
+        for(int tier = 0; valid && tier < CATALOG_TIERS; tier++) {
+            valid = (uint64_t)header->tier_offset[tier] + header->tier_count[tier] <= header->count;
+        }
+        if (!valid || header->count == 0) {
+            munmap(map, size);
+            return 0;
+        }
+        
+        catalog->map = map;
+        catalog->size = size;
+        catalog->header = header;
+        catalog->puzzles = (const CatalogPuzzle*)(header + 1);
+        return 1;
+    #endif
+}
+
+void catalog_close(PuzzleCatalog* catalog) {
+    #ifndef _WIN32
+        if (catalog->map) munmap(catalog->map, catalog->size);
+    #endif
+    memset(catalog, 0, sizeof(*catalog));
+}
+
+// A random puzzle of the given tier (any tier if negative), or NULL
+const CatalogPuzzle* catalog_pick(const PuzzleCatalog* catalog, int tier) {
+    if (!catalog->header) return NULL;
+    uint32_t offset = 0;
+    uint32_t count = catalog->header->count;
+    if (tier >= 0 && tier < CATALOG_TIERS) {
+        offset = catalog->header->tier_offset[tier];
+        count = catalog->header->tier_count[tier];
+    }
+    if (count == 0) return NULL;
+    
+    uint32_t r = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    return &catalog->puzzles[offset + r % count];
+}
+
+/*
+================================================================================
+    CHALLENGE 1: LE COMPTE EST BON
+    Find operations to reach a target number from given numbers
+================================================================================
+*/
+
+int64_t parse_sum(ExpressionParser* p);
+
+void parse_skip_spaces(ExpressionParser* p) {
+    while (isspace((unsigned char)*p->at)) p->at++;
+}
+
+// A drawn number (each used once) or a parenthesised sub-expression
+int64_t parse_operand(ExpressionParser* p) {
+    parse_skip_spaces(p);
+    if (*p->at == '(') {
+        p->at++;
+        int64_t value = parse_sum(p);
+        parse_skip_spaces(p);
+        if (*p->at != ')') p->valid = 0;
+        else p->at++;
+        return value;
+    }
+    
+    if (!isdigit((unsigned char)*p->at)) {
+        p->valid = 0;
+        return 0;
+    }
+    int64_t num = 0;
+    while (isdigit((unsigned char)*p->at) && num <= SOLVER_VALUE_LIMIT) {
+        num = num * 10 + (*p->at++ - '0');
+    }
+    for(int j = 0; j < p->count; j++) {
+        if (p->numbers[j] == num && !p->used[j]) {
+            p->used[j] = 1;
+            return num;
+        }
+    }
+    p->valid = 0;
+    return 0;
+}
+
+// Products and exact quotients
+int64_t parse_product(ExpressionParser* p) {
+    int64_t value = parse_operand(p);
+    for(;;) {
+        parse_skip_spaces(p);
+        char op = *p->at;
+        if (op != '*' && op != 'x' && op != 'X' && op != '/') return value;
+        p->at++;
+        int64_t rhs = parse_operand(p);
+        if (op == '/') {
+            if (rhs == 0 || value % rhs != 0) p->valid = 0;
+            else value /= rhs;
+        } else {
+            value *= rhs;
+        }
+        if (value > SOLVER_VALUE_LIMIT || value < -SOLVER_VALUE_LIMIT) p->valid = 0;
+        if (!p->valid) return 0;
+    }
+}
+
+int64_t parse_sum(ExpressionParser* p) {
+    int64_t value = parse_product(p);
+    for(;;) {
+        parse_skip_spaces(p);
+        char op = *p->at;
+        if (op != '+' && op != '-') return value;
+        p->at++;
+        int64_t rhs = parse_product(p);
+        value = op == '+' ? value + rhs : value - rhs;
+        if (!p->valid) return 0;
+    }
+}
+
+// Evaluate an answer with the usual precedence. It is only valid if it
+// uses drawn numbers (each at most once) and every division is exact.
+int evaluate_expression(const char* expr, int* numbers, int count, int* valid) {
+    ExpressionParser p = { expr, numbers, count, { 0 }, 1 };
+    if (count > SOLVER_MAX_NUMBERS) p.count = SOLVER_MAX_NUMBERS;
+    
+    int64_t value = parse_sum(&p);
+    parse_skip_spaces(&p);
+    if (*p.at != '\0') p.valid = 0;
+    
+    *valid = p.valid;
+    return p.valid ? (int)value : 0;
+}
+
+// Deal a catalog puzzle, or draw at random and solve it when no catalog
+// is installed
+void compte_bon_deal(Session* s, const CatalogPuzzle* puzzle) {
+    CompteBonGame* game = &s->game.compte_bon;
+    int* numbers = game->numbers;
+    
+    if (puzzle) {
+        // Solvable by construction; the solution is only worked out if the
+        // player needs to see it
+        for(int i = 0; i < COMPTE_BON_NUMBERS; i++) numbers[i] = puzzle->numbers[i];
+        game->target = puzzle->target;
+        game->best_distance = 0;
+        game->solution[0] = '\0';
+    } else {
+        // Draw until the target is reachable; most draws are, so this rarely
+        // takes more than a couple of solver runs
+        CompteBonSolver solver;
+        for(int attempt = 0; ; attempt++) {
+            // Generate random numbers from different ranges
+            numbers[0] = (rand() % 9) + 1;        // 1-9
+            numbers[1] = (rand() % 9) + 1;        // 1-9
+            numbers[2] = (rand() % 9) + 2;        // 2-10
+            numbers[3] = ((rand() % 4) + 1) * 5;  // 5, 10, 15, 20
+            numbers[4] = ((rand() % 4) + 2) * 10; // 20, 30, 40, 50
+            numbers[5] = ((rand() % 4) + 1) * 25; // 25, 50, 75, 100
+            
+            // Generate random target
+            game->target = (rand() % 800) + 100; // 100-899
+            
+            if (!solver_solve(&solver, numbers, COMPTE_BON_NUMBERS, game->target)) {
+                // Out of memory: play the draw unchecked
+                game->best_distance = 0;
+                game->solution[0] = '\0';
+                break;
+            }
+            game->best_distance = (int)solver.best_distance;
+            solver_solution(&solver, game->solution, sizeof(game->solution));
+            solver_free(&solver);
+            if (game->best_distance == 0 || attempt >= 100) break;
+        }
+    }
+    
+    session_printf(s, "Available numbers: ");
+    for(int i = 0; i < COMPTE_BON_NUMBERS; i++) {
+        session_printf(s, "%d ", numbers[i]);
+    }
+    session_printf(s, "\nTarget: %d\n", game->target);
+    if (puzzle) {
+        session_printf(s, "Difficulty: %s (%u solution%s)\n", CATALOG_TIER_NAMES[puzzle->tier],
+               puzzle->solutions, puzzle->solutions == 1 ? "" : "s");
+    }
+    session_printf(s, "\n");
+    
+    session_printf(s, "Enter your solution (e.g., (25*5)+10-2)\n");
+    session_printf(s, "Or type 'skip' to skip\n\n");
+    
+    session_printf(s, "Your solution: ");
+    challenge_begin(s);
+    s->screen = SCREEN_COMPTE_BON;
+}
+
+void challenge_compte_bon_start(Session* s) {
+    clear_screen(s);
+    display_header(s, "CHALLENGE 1: Le Compte est Bon");
+    
+    session_printf(s, "🎯 Objective: Reach the target number using the given numbers\n");
+    session_printf(s, "   You can use +, -, *, / operations\n");
+    session_printf(s, "   Each number can be used only once\n");
+    session_printf(s, "   Not exact? The closer you get, the more you score\n\n");
+    
+    if (!puzzle_catalog.header) {
+        compte_bon_deal(s, NULL);
+        return;
+    }
+    
+    session_printf(s, "Difficulty: ");
+    for(int tier = 0; tier < CATALOG_TIERS; tier++) {
+        session_printf(s, "%d. %s  ", tier + 1, CATALOG_TIER_NAMES[tier]);
+    }
+    session_printf(s, "\nChoose a difficulty (Enter for any): ");
+    s->screen = SCREEN_COMPTE_BON_LEVEL;
+}
+
+void challenge_compte_bon_level_input(Session* s, const char* input) {
+    int tier = input[0] ? atoi(input) - 1 : -1;
+    if (input[0] && (tier < 0 || tier >= CATALOG_TIERS)) {
+        session_printf(s, "Choose a difficulty (1-%d, Enter for any): ", CATALOG_TIERS);
+        return;
+    }
+    
+    session_printf(s, "\n");
+    compte_bon_deal(s, catalog_pick(&puzzle_catalog, tier));
+}
+
+// Work out the solution of a catalog puzzle the first time it is shown
+void compte_bon_explain(CompteBonGame* game) {
+    if (game->solution[0]) return;
+    CompteBonSolver solver;
+    if (!solver_solve(&solver, game->numbers, COMPTE_BON_NUMBERS, game->target)) return;
+    solver_solution(&solver, game->solution, sizeof(game->solution));
+    solver_free(&solver);
+}
+
+void challenge_compte_bon_input(Session* s, const char* solution) {
+    CompteBonGame* game = &s->game.compte_bon;
+    int target = game->target;
+    
+    int64_t elapsed = challenge_elapsed_ns(s);
+    
+    if (strcmp(solution, "skip") == 0) {
+        session_printf(s, "\n❌ Challenge skipped!\n");
+        challenge_record_attempt(s, CHALLENGE_COMPTE_BON, 0, 0);
+        pause_screen(s);
+        return;
+    }
+    
+    // Validate solution
+    int valid = 0;
+    int result = evaluate_expression(solution, game->numbers, COMPTE_BON_NUMBERS, &valid);
+    int distance = result > target ? result - target : target - result;
+    int miss = distance - game->best_distance; // How much closer was possible
+    
+    if (valid && miss <= COMPTE_BON_MAX_MISS) {
+        // Calculate score based on time, minus 2 points per unit the answer
+        // could have been closer
+        int base_score = POINTS_COMPTE_BON;
+        int time_penalty = (int)(elapsed / (30 * NS_PER_SECOND)) * 2; // -2 points per 30 seconds
+        int score = base_score - time_penalty - (miss > 0 ? miss * 2 : 0);
+        if (score < 5) score = 5; // Minimum score
+        
+        if (distance == 0) {
+            session_printf(s, "\n✅ Correct! Your solution works!\n");
+        } else if (miss <= 0) {
+            session_printf(s, "\n✅ %d is as close as this draw allows!\n", result);
+        } else {
+            compte_bon_explain(game);
+            session_printf(s, "\n🎯 Close! Your solution gives %d, %d away from the target.\n", result, distance);
+            session_printf(s, "💡 Best possible: %s\n", game->solution);
+        }
+        session_printf(s, "🎯 Score earned: %d points\n", score);
+        
+        challenge_record_attempt(s, CHALLENGE_COMPTE_BON, score, distance);
+    } else {
+        if (valid) {
+            session_printf(s, "\n❌ Your solution gives %d, too far from the target: %d\n", result, target);
+        } else {
+            session_printf(s, "\n❌ Invalid solution! Make sure you:\n");
+            session_printf(s, "   • Use only the given numbers (each once)\n");
+            session_printf(s, "   • Only divide when the result is a whole number\n");
+        }
+        compte_bon_explain(game);
+        if (game->solution[0]) {
+            session_printf(s, "💡 One solution: %s\n", game->solution);
+        }
+        challenge_record_attempt(s, CHALLENGE_COMPTE_BON, 0, valid ? distance : 0);
+    }
+    
+    pause_screen(s);
+}
+
+/*
+================================================================================
+    MASTERMIND ENGINE
+    Codes still consistent with the feedback, kept as a packed bitset
+================================================================================
+*/
+
+const MastermindVariant MASTERMIND_VARIANTS[MASTERMIND_VARIANT_COUNT] = {
+    { "Classic", 4, 6, 1, 10 },
+    { "Grand", 6, 10, 0, 12 },
+};
+
+// Digits of every code of a variant, indexed by code; built on first use
+MastermindTable mastermind_tables[MASTERMIND_VARIANT_COUNT];
+
+// n * log2(n) for every bucket size a sample can produce
+double mastermind_nlogn[MASTERMIND_SAMPLE_CODES + 1];
+
+// log2(x) for x >= 1 by repeated squaring, so the game needs no libm
+double binary_log(double x) {
+    double result = 0;
+    while (x >= 2) {
+        x /= 2;
+        result += 1;
+    }
+    double bit = 1;
+    for(int i = 0; i < 24; i++) {
+        x *= x;
+        bit /= 2;
+        if (x >= 2) {
+            x /= 2;
+            result += bit;
+        }
+    }
+    return result;
+}
+
+MastermindTable* mastermind_table(int variant) {
+    MastermindTable* table = &mastermind_tables[variant];
+    if (table->digits) return table;
+    
+    const MastermindVariant* v = &MASTERMIND_VARIANTS[variant];
+    uint32_t count = 1;
+    for(int i = 0; i < v->pegs; i++) count *= v->colors;
+    
+    uint8_t (*digits)[MASTERMIND_MAX_PEGS] = malloc(sizeof(*digits) * count);
+    if (!digits) return NULL;
+    for(uint32_t code = 0; code < count; code++) {
+        uint32_t rest = code;
+        for(int i = 0; i < v->pegs; i++) {
+            digits[code][i] = rest % v->colors;
+            rest /= v->colors;
+        }
+    }
+    
+    table->pegs = v->pegs;
+    table->colors = v->colors;
+    table->count = count;
+    table->win = 1;
+    for(int i = 0; i < v->pegs; i++) table->win *= 3;
+    table->outcomes = table->win;
+    table->win -= 1;
+    table->digits = digits;
+    table->opening[MASTERMIND_ENTROPY] = -1;
+    table->opening[MASTERMIND_KNUTH] = -1;
+    for(int i = 0; i < MASTERMIND_MAX_OUTCOMES; i++) table->reply[i] = -1;
+    
+    if (mastermind_nlogn[2] == 0) {
+        for(int n = 2; n <= MASTERMIND_SAMPLE_CODES; n++) {
+            mastermind_nlogn[n] = n * binary_log(n);
+        }
+    }
+    return table;
+}
+
+// Per-position feedback as a base-3 number, digit i for peg i: 2 = right
+// colour and place, 1 = right colour elsewhere, 0 = wrong. Misplaced marks
+// go left to right while the secret still has that colour unmatched.
+int mastermind_feedback(const uint8_t* guess, const uint8_t* code, int pegs) {
+    static const int weight[MASTERMIND_MAX_PEGS] = { 1, 3, 9, 27, 81, 243 };
+    uint8_t unmatched[MASTERMIND_MAX_COLORS] = { 0 };
+    int exact = 0;
+    int feedback = 0;
+    for(int i = 0; i < pegs; i++) {
+        if (guess[i] == code[i]) {
+            exact |= 1 << i;
+            feedback += 2 * weight[i];
+        } else {
+            unmatched[code[i]]++;
+        }
+    }
+    if (exact == (1 << pegs) - 1) return feedback;
+    
+    for(int i = 0; i < pegs; i++) {
+        if (!(exact & (1 << i)) && unmatched[guess[i]] > 0) {
+            unmatched[guess[i]]--;
+            feedback += weight[i];
+        }
+    }
+    return feedback;
+}
+
+int mastermind_engine_init(MastermindEngine* engine, int variant) {
+    memset(engine, 0, sizeof(*engine));
+    engine->table = mastermind_table(variant);
+    if (!engine->table) return 0;
+    
+    uint32_t count = engine->table->count;
+    size_t words = (count + 63) / 64;
+    engine->consistent = malloc(words * sizeof(uint64_t));
+    if (!engine->consistent) return 0;
+    memset(engine->consistent, 0xff, words * sizeof(uint64_t));
+    if (count % 64) engine->consistent[words - 1] = (1ull << (count % 64)) - 1;
+    engine->remaining = count;
+    return 1;
+}
+
+void mastermind_engine_free(MastermindEngine* engine) {
+    free(engine->consistent);
+    engine->consistent = NULL;
+}
+
+// Clear the codes in words [begin, end) that would not have given feedback
+uint32_t mastermind_filter_range(MastermindEngine* engine, const uint8_t* guess, int feedback, size_t begin, size_t end) {
+    const MastermindTable* table = engine->table;
+    uint32_t kept = 0;
+    for(size_t w = begin; w < end; w++) {
+        uint64_t bits = engine->consistent[w];
+        uint64_t keep = 0;
+        while (bits) {
+            int bit = __builtin_ctzll(bits);
+            bits &= bits - 1;
+            uint32_t code = (uint32_t)(w * 64 + bit);
+            if (mastermind_feedback(guess, table->digits[code], table->pegs) == feedback) {
+                keep |= 1ull << bit;
+            }
+        }
+        engine->consistent[w] = keep;
+        kept += __builtin_popcountll(keep);
+    }
+    return kept;
+}
+
+// Partition the sampled codes by each candidate guess's feedback and rate
+// the split: the largest bucket (Knuth) or the information it yields
+void mastermind_score_range(MastermindJob* job, size_t begin, size_t end) {
+    const MastermindTable* table = job->engine->table;
+    uint32_t buckets[MASTERMIND_MAX_OUTCOMES];
+    
+    for(size_t g = begin; g < end; g++) {
+        const uint8_t* guess = table->digits[job->guesses[g]];
+        memset(buckets, 0, sizeof(uint32_t) * table->outcomes);
+        for(uint32_t i = 0; i < job->code_count; i++) {
+            buckets[mastermind_feedback(guess, table->digits[job->codes[i]], table->pegs)]++;
+        }
+        
+        double score = 0;
+        if (job->strategy == MASTERMIND_KNUTH) {
+            uint32_t worst = 0;
+            for(int f = 0; f < table->outcomes; f++) {
+                if (buckets[f] > worst) worst = buckets[f];
+            }
+            score = -(double)worst;
+        } else {
+            // Entropy up to a constant: -sum(n log n)
+            for(int f = 0; f < table->outcomes; f++) {
+                score -= mastermind_nlogn[buckets[f]];
+            }
+        }
+        // A guess that could itself be the secret breaks ties
+        if (buckets[table->win]) score += 1e-6;
+        job->scores[g] = score;
+    }
+}
+
+#ifndef _WIN32
+// Worker: filter or score chunks of the job until none are left
+void* mastermind_worker(void* arg) {
+    MastermindJob* job = arg;
+    for(;;) {
+        pthread_mutex_lock(&job->lock);
+        size_t begin = job->next;
+        job->next += job->chunk;
+        pthread_mutex_unlock(&job->lock);
+        if (begin >= job->total) return NULL;
+        size_t end = begin + job->chunk < job->total ? begin + job->chunk : job->total;
+        
+        if (job->guess) {
+            uint32_t kept = mastermind_filter_range(job->engine, job->guess, job->feedback, begin, end);
+            pthread_mutex_lock(&job->lock);
+            job->kept += kept;
+            pthread_mutex_unlock(&job->lock);
+        } else {
+            mastermind_score_range(job, begin, end);
+        }
+    }
+}
+
+// Run a job on every core; returns 0 if it should just run inline
+int mastermind_parallel(MastermindJob* job) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > SOLVER_MAX_THREADS ? SOLVER_MAX_THREADS : (int)cpus;
+    if (threads < 2) return 0;
+    
+    pthread_t workers[SOLVER_MAX_THREADS];
+    int started = 0;
+    pthread_mutex_init(&job->lock, NULL);
+    while (started < threads - 1 &&
+           pthread_create(&workers[started], NULL, mastermind_worker, job) == 0) {
+        started++;
+    }
+    mastermind_worker(job);
+    for(int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+    pthread_mutex_destroy(&job->lock);
+    return 1;
+}
+#endif
+
+// Keep only the codes that would have answered guess with feedback
+void mastermind_engine_filter(MastermindEngine* engine, const uint8_t* guess, int feedback) {
+    size_t words = (engine->table->count + 63) / 64;
+    
+    #ifndef _WIN32
+        if (engine->table->count >= MASTERMIND_PARALLEL_MIN) {
+            MastermindJob job;
+            memset(&job, 0, sizeof(job));
+            job.engine = engine;
+            job.guess = guess;
+            job.feedback = feedback;
+            job.total = words;
+            job.chunk = 1024;
+            if (mastermind_parallel(&job)) {
+                engine->remaining = job.kept;
+                return;
+            }
+        }
+    #endif
+    
+    engine->remaining = mastermind_filter_range(engine, guess, feedback, 0, words);
+}
+
+// Up to limit consistent codes, evenly spread over the set
+uint32_t mastermind_engine_sample(const MastermindEngine* engine, uint32_t* out, uint32_t limit) {
+    uint32_t stride = engine->remaining > limit ? (engine->remaining + limit - 1) / limit : 1;
+    uint32_t seen = 0;
+    uint32_t taken = 0;
+    size_t words = (engine->table->count + 63) / 64;
+    for(size_t w = 0; w < words && taken < limit; w++) {
+        uint64_t bits = engine->consistent[w];
+        while (bits && taken < limit) {
+            int bit = __builtin_ctzll(bits);
+            bits &= bits - 1;
+            if (seen++ % stride == 0) out[taken++] = (uint32_t)(w * 64 + bit);
+        }
+    }
+    return taken;
+}
+
+// Best next guess under the strategy. Small sets are searched exactly over
+// every code; large ones are sampled to stay within MASTERMIND_HINT_BUDGET.
+uint32_t mastermind_engine_suggest(MastermindEngine* engine, MastermindStrategy strategy) {
+    const MastermindTable* table = engine->table;
+    if (engine->remaining <= 2) {
+        uint32_t code = 0;
+        mastermind_engine_sample(engine, &code, 1);
+        return code;
+    }
+    
+    // The opening does not depend on the secret, so it is worked out once
+    int opening = engine->remaining == table->count;
+    if (opening && table->opening[strategy] >= 0) return (uint32_t)table->opening[strategy];
+    
+    MastermindJob job;
+    memset(&job, 0, sizeof(job));
+    job.engine = engine;
+    job.strategy = strategy;
+    
+    uint32_t code_limit = engine->remaining < MASTERMIND_SAMPLE_CODES ? engine->remaining : MASTERMIND_SAMPLE_CODES;
+    job.codes = malloc(sizeof(uint32_t) * code_limit);
+    job.code_count = job.codes ? mastermind_engine_sample(engine, job.codes, code_limit) : 0;
+    
+    uint32_t guess_limit = MASTERMIND_HINT_BUDGET / (job.code_count ? job.code_count : 1);
+    if (guess_limit < 1) guess_limit = 1;
+    if ((uint64_t)table->count <= guess_limit) {
+        // Every code, including ones already ruled out (Knuth's rule)
+        guess_limit = table->count;
+        job.guesses = malloc(sizeof(uint32_t) * guess_limit);
+        for(uint32_t i = 0; job.guesses && i < guess_limit; i++) job.guesses[i] = i;
+    } else {
+        if (guess_limit > engine->remaining) guess_limit = engine->remaining;
+        job.guesses = malloc(sizeof(uint32_t) * guess_limit);
+        if (job.guesses) guess_limit = mastermind_engine_sample(engine, job.guesses, guess_limit);
+    }
+    job.scores = malloc(sizeof(double) * guess_limit);
+    
+    uint32_t best = job.codes && job.code_count ? job.codes[0] : 0;
+    if (job.codes && job.guesses && job.scores) {
+        job.total = guess_limit;
+        job.chunk = 16;
+        int done = 0;
+        #ifndef _WIN32
+            done = job.code_count * (uint64_t)guess_limit >= MASTERMIND_PARALLEL_MIN && mastermind_parallel(&job);
+        #endif
+        if (!done) mastermind_score_range(&job, 0, guess_limit);
+        
+        double best_score = -1e300;
+        for(uint32_t g = 0; g < guess_limit; g++) {
+            if (job.scores[g] > best_score) {
+                best_score = job.scores[g];
+                best = job.guesses[g];
+            }
+        }
+    }
+    
+    free(job.codes);
+    free(job.guesses);
+    free(job.scores);
+    if (opening) engine->table->opening[strategy] = best;
+    return best;
+}
+
+// Play the next guess of the engine's own game against the player's secret,
+// so its guess count is known by the time the player wins without solving
+// anything then. The solver is deterministic: its opening and its reply to
+// each feedback are kept in the table, so after the first games every step
+// searches a set already cut down twice.
+void mastermind_solver_step(MastermindGame* game) {
+    MastermindEngine* solver = &game->solver;
+    MastermindTable* table = solver->table;
+    if (game->solver_solved || game->solver_guesses >= MASTERMIND_MAX_ATTEMPTS) return;
+    
+    int32_t* reply = game->solver_guesses == 1 ? &table->reply[game->solver_opening] : NULL;
+    uint32_t guess = reply && *reply >= 0 ? (uint32_t)*reply : mastermind_engine_suggest(solver, MASTERMIND_ENTROPY);
+    if (reply) *reply = (int32_t)guess;
+    
+    int feedback = mastermind_feedback(table->digits[guess], game->secret, table->pegs);
+    if (game->solver_guesses == 0) game->solver_opening = feedback;
+    game->solver_guesses++;
+    if (feedback == table->win) game->solver_solved = 1;
+    else mastermind_engine_filter(solver, table->digits[guess], feedback);
+}
+
+/*
+================================================================================
+    CHALLENGE 2: MASTERMIND ALGORITHMIQUE
+    Guess the secret sequence with feedback on correct/misplaced digits
+================================================================================
+*/
+
+// Prompt for the next guess
+void mastermind_prompt(Session* s) {
+    MastermindGame* game = &s->game.mastermind;
+    const MastermindVariant* v = &MASTERMIND_VARIANTS[game->variant];
+    session_printf(s, "\nAttempt %d/%d (%u codes left)\n", game->attempts + 1, game->max_attempts, game->engine.remaining);
+    session_printf(s, "Enter %d digits (%d-%d), 'hint' or 'hint knuth': ",
+           v->pegs, v->first_color, v->first_color + v->colors - 1);
+}
+
+void challenge_mastermind_start(Session* s) {
+    clear_screen(s);
+    display_header(s, "CHALLENGE 2: Mastermind Algorithmique");
+    
+    session_printf(s, "🎯 Objective: Guess the secret sequence\n");
+    session_printf(s, "   After each guess, you'll get feedback for each position:\n");
+    session_printf(s, "   • ✓ = Correct digit in correct position\n");
+    session_printf(s, "   • ? = Correct digit in wrong position\n");
+    session_printf(s, "   • x = Wrong digit\n");
+    session_printf(s, "   Scored against the guesses a solver needs; each hint costs %d points\n\n", MASTERMIND_HINT_COST);
+    
+    for(int i = 0; i < MASTERMIND_VARIANT_COUNT; i++) {
+        const MastermindVariant* v = &MASTERMIND_VARIANTS[i];
+        session_printf(s, "%d. %s: %d digits (%d-%d), %d attempts\n", i + 1, v->name,
+               v->pegs, v->first_color, v->first_color + v->colors - 1, v->max_attempts);
+    }
+    session_printf(s, "\nChoose a variant (Enter for Classic): ");
+    s->screen = SCREEN_MASTERMIND_VARIANT;
+}
+
+void challenge_mastermind_variant_input(Session* s, const char* input) {
+    MastermindGame* game = &s->game.mastermind;
+    int variant = input[0] ? atoi(input) - 1 : 0;
+    if (variant < 0 || variant >= MASTERMIND_VARIANT_COUNT) {
+        session_printf(s, "Choose a variant (1-%d): ", MASTERMIND_VARIANT_COUNT);
+        return;
+    }
+    
+    if (!mastermind_engine_init(&game->engine, variant) || !mastermind_engine_init(&game->solver, variant)) {
+        mastermind_engine_free(&game->engine);
+        mastermind_engine_free(&game->solver);
+        session_printf(s, "\n❌ Not enough memory for this variant.\n");
+        pause_screen(s);
+        return;
+    }
+    
+    // Generate secret sequence
+    const MastermindVariant* v = &MASTERMIND_VARIANTS[variant];
+    game->variant = variant;
+    for(int i = 0; i < v->pegs; i++) {
+        game->secret[i] = rand() % v->colors;
+    }
+    
+    game->attempts = 0;
+    game->max_attempts = v->max_attempts;
+    game->hints = 0;
+    game->solver_guesses = 0;
+    game->solver_solved = 0;
+    
+    mastermind_prompt(s);
+    challenge_begin(s);
+    s->screen = SCREEN_MASTERMIND;
+}
+
+// Leave the game, releasing the engines' bitsets
+void mastermind_finish(Session* s) {
+    mastermind_engine_free(&s->game.mastermind.engine);
+    mastermind_engine_free(&s->game.mastermind.solver);
+    pause_screen(s);
+}
+
+void challenge_mastermind_input(Session* s, const char* input) {
+    MastermindGame* game = &s->game.mastermind;
+    const MastermindVariant* v = &MASTERMIND_VARIANTS[game->variant];
+    const MastermindTable* table = game->engine.table;
+    int pegs = v->pegs;
+    
+    if (strncmp(input, "hint", 4) == 0) {
+        MastermindStrategy strategy = strstr(input, "knuth") ? MASTERMIND_KNUTH : MASTERMIND_ENTROPY;
+        uint32_t code = mastermind_engine_suggest(&game->engine, strategy);
+        game->hints++;
+        
+        session_printf(s, "💡 %u code%s still fit%s the feedback. Try: ", game->engine.remaining,
+               game->engine.remaining == 1 ? "" : "s", game->engine.remaining == 1 ? "s" : "");
+        for(int i = 0; i < pegs; i++) session_printf(s, "%d ", table->digits[code][i] + v->first_color);
+        session_printf(s, "\n");
+        mastermind_prompt(s);
+        return;
+    }
+    
+    // Digits may be separated by spaces or not
+    uint8_t guess[MASTERMIND_MAX_PEGS] = { 0 };
+    int count = 0;
+    int valid = 1;
+    for(const char* c = input; *c && valid; c++) {
+        if (isspace((unsigned char)*c)) continue;
+        int color = *c - '0' - v->first_color;
+        if (!isdigit((unsigned char)*c) || color < 0 || color >= v->colors || count == pegs) valid = 0;
+        else guess[count++] = color;
+    }
+    if (!valid || count != pegs) {
+        session_printf(s, "❌ Invalid input! Please enter %d digits from %d to %d.\n",
+               pegs, v->first_color, v->first_color + v->colors - 1);
+        mastermind_prompt(s);
+        return;
+    }
+    
+    game->attempts++;
+    int feedback = mastermind_feedback(guess, game->secret, pegs);
+    mastermind_engine_filter(&game->engine, guess, feedback);
+    mastermind_solver_step(game);
+    
+    // Display feedback per position
+    session_printf(s, "Feedback: ");
+    for(int i = 0, f = feedback; i < pegs; i++, f /= 3) {
+        if (f % 3 == 2) session_printf(s, "✓ ");
+        else if (f % 3 == 1) session_printf(s, "? ");
+        else session_printf(s, "x ");
+    }
+    session_printf(s, "\n");
+    
+    // Check win condition
+    int won = feedback == table->win;
+    
+    if (!won && game->attempts < game->max_attempts) {
+        mastermind_prompt(s);
+        return;
+    }
+    
+    if (won) {
+        // Score against the guesses the engine needs for the same secret;
+        // matching or beating it keeps full points. It has played as many
+        // guesses as the player, so if it has not won yet it needs more
+        int par = game->solver_solved ? game->solver_guesses : 0;
+        int extra = par > 0 && game->attempts > par ? game->attempts - par : 0;
+        int score = POINTS_MASTERMIND - extra * MASTERMIND_EXTRA_GUESS_COST - game->hints * MASTERMIND_HINT_COST;
+        if (score < 5) score = 5;
+        
+        session_printf(s, "\n✅ Congratulations! You cracked the code!\n");
+        if (par > 0) session_printf(s, "🎯 Attempts: %d (solver: %d)\n", game->attempts, par);
+        else session_printf(s, "🎯 Attempts: %d (solver: more than %d)\n", game->attempts, game->attempts);
+        if (game->hints > 0) session_printf(s, "💡 Hints used: %d\n", game->hints);
+        session_printf(s, "🎯 Score earned: %d points\n", score);
+        
+        challenge_record_attempt(s, CHALLENGE_MASTERMIND, score, game->attempts);
+    } else {
+        session_printf(s, "\n❌ Out of attempts! The secret was: ");
+        for(int i = 0; i < pegs; i++) session_printf(s, "%d ", game->secret[i] + v->first_color);
+        session_printf(s, "\n");
+        challenge_record_attempt(s, CHALLENGE_MASTERMIND, 0, game->attempts);
+    }
+    
+    mastermind_finish(s);
+}
+
+/*
+================================================================================
+    MAZE
+    Seeded maze generation on a bit-packed grid, one bit per cell
+================================================================================
+*/
+
+int bit_test(const uint64_t* bits, size_t i) {
+    return (bits[i >> 6] >> (i & 63)) & 1;
+}
+
+void bit_set(uint64_t* bits, size_t i) {
+    bits[i >> 6] |= 1ull << (i & 63);
+}
+
+void bit_clear(uint64_t* bits, size_t i) {
+    bits[i >> 6] &= ~(1ull << (i & 63));
+}
+
+// splitmix64: small, fast, and the same sequence everywhere for a seed
+uint64_t maze_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Bit index of a cell; rows are padded to whole words
+size_t maze_index(const Maze* maze, int row, int col) {
+    return (size_t)row * maze->stride + col;
+}
+
+int maze_is_open(const Maze* maze, int row, int col) {
+    return row >= 0 && row < maze->rows && col >= 0 && col < maze->cols &&
+           !bit_test(maze->walls, maze_index(maze, row, col));
+}
+
+void maze_free(Maze* maze) {
+    free(maze->walls);
+    free(maze->trail);
+    free(maze->distance);
+    maze->walls = NULL;
+    maze->trail = NULL;
+    maze->distance = NULL;
+}
+
+// Append to a growable cell list; 0 when out of memory
+int cell_list_push(CellList* list, uint32_t cell) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        uint32_t* cells = realloc(list->cells, sizeof(uint32_t) * capacity);
+        if (!cells) return 0;
+        list->cells = cells;
+        list->capacity = capacity;
+    }
+    list->cells[list->count++] = cell;
+    return 1;
+}
+
+// Length of the shortest path from the start to the goal, or -1. Only the
+// current and next BFS frontiers are stored, next to a visited bitset, so
+// memory follows the widest frontier rather than the maze area.
+int maze_shortest_path(const Maze* maze, uint64_t* expanded) {
+    static const int DR[4] = { -1, 1, 0, 0 };
+    static const int DC[4] = { 0, 0, 1, -1 };
+    
+    size_t words = (size_t)maze->rows * maze->stride / 64;
+    uint64_t* visited = calloc(words, sizeof(uint64_t));
+    CellList frontier = { NULL, 0, 0 };
+    CellList next = { NULL, 0, 0 };
+    int ok = visited && cell_list_push(&frontier, 0);
+    if (ok) bit_set(visited, 0);
+    
+    int distance = 0;
+    int found = maze->goal_row == 0 && maze->goal_col == 0;
+    while (ok && !found && frontier.count > 0) {
+        next.count = 0;
+        for(size_t i = 0; ok && i < frontier.count; i++) {
+            int row = frontier.cells[i] / maze->cols;
+            int col = frontier.cells[i] % maze->cols;
+            (*expanded)++;
+            for(int d = 0; d < 4; d++) {
+                int r = row + DR[d];
+                int c = col + DC[d];
+                if (!maze_is_open(maze, r, c) || bit_test(visited, maze_index(maze, r, c))) continue;
+                bit_set(visited, maze_index(maze, r, c));
+                if (r == maze->goal_row && c == maze->goal_col) found = 1;
+                ok = ok && cell_list_push(&next, (uint32_t)r * maze->cols + c);
+            }
+        }
+        distance++;
+        
+        CellList swap = frontier;
+        frontier = next;
+        next = swap;
+    }
+    
+    free(visited);
+    free(frontier.cells);
+    free(next.cells);
+    return ok && found ? distance : -1;
+}
+
+// Steps from every cell to the goal (UINT32_MAX where unreachable), by one
+// BFS from the goal. A path is still shortest exactly when each step lowers
+// the distance by one.
+uint32_t* maze_distance_field(const Maze* maze) {
+    size_t cells = (size_t)maze->rows * maze->cols;
+    uint32_t* distance = malloc(sizeof(uint32_t) * cells);
+    uint32_t* queue = malloc(sizeof(uint32_t) * cells);
+    if (!distance || !queue) {
+        free(distance);
+        free(queue);
+        return NULL;
+    }
+    memset(distance, 0xff, sizeof(uint32_t) * cells);
+    
+    static const int DR[4] = { -1, 1, 0, 0 };
+    static const int DC[4] = { 0, 0, 1, -1 };
+    size_t head = 0, tail = 0;
+    uint32_t goal = (uint32_t)maze->goal_row * maze->cols + maze->goal_col;
+    distance[goal] = 0;
+    queue[tail++] = goal;
+    while (head < tail) {
+        uint32_t cell = queue[head++];
+        int row = cell / maze->cols;
+        int col = cell % maze->cols;
+        for(int d = 0; d < 4; d++) {
+            int r = row + DR[d];
+            int c = col + DC[d];
+            uint32_t next = (uint32_t)r * maze->cols + c;
+            if (maze_is_open(maze, r, c) && distance[next] == UINT32_MAX) {
+                distance[next] = distance[cell] + 1;
+                queue[tail++] = next;
+            }
+        }
+    }
+    free(queue);
+    return distance;
+}
+
+// Carve a maze with an iterative recursive backtracker. Rooms sit on even
+// coordinates and passages open the cell between two rooms; afterwards a
+// few more walls between rooms are knocked out so routes can differ in
+// length. The goal is the bottom-right room.
+int maze_generate(Maze* maze, int rows, int cols, uint64_t seed) {
+    memset(maze, 0, sizeof(*maze));
+    maze->rows = rows;
+    maze->cols = cols;
+    maze->seed = seed;
+    maze->stride = (size_t)(cols + 63) / 64 * 64;
+    maze->goal_row = (rows - 1) & ~1;
+    maze->goal_col = (cols - 1) & ~1;
+    
+    size_t words = (size_t)rows * maze->stride / 64;
+    int room_rows = (rows + 1) / 2;
+    int room_cols = (cols + 1) / 2;
+    maze->walls = malloc(words * sizeof(uint64_t));
+    maze->trail = calloc(words, sizeof(uint64_t));
+    uint32_t* stack = malloc(sizeof(uint32_t) * room_rows * room_cols);
+    if (!maze->walls || !maze->trail || !stack) {
+        free(stack);
+        maze_free(maze);
+        return 0;
+    }
+    memset(maze->walls, 0xff, words * sizeof(uint64_t));
+    
+    static const int DR[4] = { -1, 1, 0, 0 };
+    static const int DC[4] = { 0, 0, 1, -1 };
+    uint64_t state = seed;
+    size_t top = 0;
+    stack[top++] = 0;
+    bit_clear(maze->walls, 0);
+    
+    while (top > 0) {
+        uint32_t room = stack[top - 1];
+        int row = room / room_cols * 2;
+        int col = room % room_cols * 2;
+        
+        // Unvisited rooms two cells away are still walled in
+        int options[4];
+        int count = 0;
+        for(int d = 0; d < 4; d++) {
+            int r = row + 2 * DR[d];
+            int c = col + 2 * DC[d];
+            if (r >= 0 && r < rows && c >= 0 && c < cols &&
+                bit_test(maze->walls, maze_index(maze, r, c))) {
+                options[count++] = d;
+            }
+        }
+        if (count == 0) {
+            top--;
+            continue;
+        }
+        
+        int d = options[maze_random(&state) % count];
+        bit_clear(maze->walls, maze_index(maze, row + DR[d], col + DC[d]));
+        bit_clear(maze->walls, maze_index(maze, row + 2 * DR[d], col + 2 * DC[d]));
+        stack[top++] = (uint32_t)((row / 2 + DR[d]) * room_cols + col / 2 + DC[d]);
+    }
+    free(stack);
+    
+    // Extra openings between rooms make some routes shorter than others
+    for(int row = 0; row < rows; row++) {
+        for(int col = (row & 1) ? 0 : 1; col < cols; col += 2) {
+            int between_rows = (row & 1) && row + 1 < rows;
+            int between_cols = !(row & 1) && col + 1 < cols;
+            if ((between_rows || between_cols) &&
+                maze_random(&state) % 100 < MAZE_LOOP_PERCENT) {
+                bit_clear(maze->walls, maze_index(maze, row, col));
+            }
+        }
+    }
+    
+    // One BFS from the goal answers every later "how far from here" in O(1)
+    maze->distance = maze_distance_field(maze);
+    if (!maze->distance || maze->distance[0] == UINT32_MAX) {
+        maze_free(maze);
+        return 0;
+    }
+    maze->optimal = (int)maze->distance[0];
+    return 1;
+}
+
+void path_reader_init(PathReader* reader) {
+    memset(reader, 0, sizeof(*reader));
+    reader->count = -1;
+    reader->valid = 1;
+    reader->detour_step = -1;
+}
+
+// Apply the pending run, one cell at a time, stopping at the first wall.
+// A step stays on a shortest route exactly when it is one closer to the
+// goal in the maze's distance field.
+void path_reader_flush(PathReader* reader, Maze* maze) {
+    if (!reader->direction || !reader->valid) return;
+    long long count = reader->count < 0 ? 1 : reader->count;
+    
+    int dr = 0, dc = 0;
+    switch (reader->direction) {
+        case 'N': dr = -1; break;
+        case 'S': dr = 1; break;
+        case 'E': dc = 1; break;
+        case 'O': dc = -1; break;
+    }
+    for(long long i = 0; i < count; i++) {
+        int row = reader->row + dr;
+        int col = reader->col + dc;
+        if (!maze_is_open(maze, row, col)) {
+            reader->valid = 0;
+            snprintf(reader->error, sizeof(reader->error), "hit a wall going %c from row %d, column %d after %lld steps",
+                     reader->direction, reader->row, reader->col, reader->steps);
+            return;
+        }
+        reader->steps++;
+        if (maze->distance[(size_t)row * maze->cols + col] + 1 !=
+            maze->distance[(size_t)reader->row * maze->cols + reader->col]) {
+            if (reader->detour_step < 0) {
+                reader->detour_step = reader->steps;
+                reader->detour_row = reader->row;
+                reader->detour_col = reader->col;
+            }
+            reader->detours++;
+        }
+        reader->row = row;
+        reader->col = col;
+        bit_set(maze->trail, maze_index(maze, row, col));
+    }
+    reader->direction = 0;
+    reader->count = -1;
+}
+
+// Consume the next chunk of a path; returns 0 once the path is invalid
+int path_reader_feed(PathReader* reader, Maze* maze, const char* data, size_t len) {
+    for(size_t i = 0; i < len && reader->valid; i++) {
+        char c = toupper((unsigned char)data[i]);
+        if (isdigit((unsigned char)c) && reader->direction) {
+            if (reader->count < 0) reader->count = 0;
+            reader->count = reader->count * 10 + (c - '0');
+            if (reader->count > PATH_RUN_MAX) reader->count = PATH_RUN_MAX;
+        } else if (c == 'N' || c == 'S' || c == 'E' || c == 'O') {
+            path_reader_flush(reader, maze);
+            reader->direction = c;
+        } else if (!isspace((unsigned char)c) && c != ',') {
+            path_reader_flush(reader, maze);
+            if (!reader->valid) break;
+            reader->valid = 0;
+            snprintf(reader->error, sizeof(reader->error), "unexpected '%c' after %lld steps", data[i], reader->steps);
+        }
+    }
+    return reader->valid;
+}
+
+// The path is complete: apply the last run
+int path_reader_finish(PathReader* reader, Maze* maze) {
+    path_reader_flush(reader, maze);
+    return reader->valid;
+}
+
+// Feed a whole file (or stdin for "-") through a reader
+int path_reader_feed_file(PathReader* reader, Maze* maze, const char* path) {
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!file) return 0;
+    
+    char* chunk = malloc(PATH_READ_CHUNK);
+    size_t n;
+    while (chunk && reader->valid && (n = fread(chunk, 1, PATH_READ_CHUNK, file)) > 0) {
+        path_reader_feed(reader, maze, chunk, n);
+    }
+    free(chunk);
+    if (file != stdin) fclose(file);
+    return chunk != NULL;
+}
+
+// --check-path SIZE SEED [FILE]: check a path against a generated maze
+// without the game, reading the path from a file or a pipe
+int path_check_main(int argc, char** argv) {
+    if (argc < 4) {
+        printf("Usage: %s --check-path SIZE SEED [FILE]\n", argv[0]);
+        return 2;
+    }
+    int size = atoi(argv[2]);
+    unsigned long long seed = strtoull(argv[3], NULL, 10);
+    if (size < MAZE_MIN_SIZE || size > MAZE_MAX_SIZE) {
+        printf("❌ Maze size must be between %d and %d.\n", MAZE_MIN_SIZE, MAZE_MAX_SIZE);
+        return 2;
+    }
+    
+    Maze maze;
+    if (!maze_generate(&maze, size, size, seed)) {
+        printf("❌ Not enough memory for a %dx%d maze.\n", size, size);
+        return 1;
+    }
+    
+    PathReader reader;
+    path_reader_init(&reader);
+    const char* file = argc > 4 ? argv[4] : "-";
+    if (!path_reader_feed_file(&reader, &maze, file)) {
+        printf("❌ Could not read %s.\n", file);
+        maze_free(&maze);
+        return 1;
+    }
+    path_reader_finish(&reader, &maze);
+    
+    int reached = reader.valid && reader.row == maze.goal_row && reader.col == maze.goal_col;
+    if (reached) {
+        printf("✅ Reached the goal in %lld steps (shortest: %d)\n", reader.steps, maze.optimal);
+        if (reader.detour_step >= 0) {
+            printf("   First left a shortest route on step %lld, from row %d, column %d\n",
+                   reader.detour_step, reader.detour_row, reader.detour_col);
+        }
+    } else if (reader.valid) {
+        printf("❌ Stopped at row %d, column %d after %lld steps, %u from the goal\n", reader.row, reader.col, reader.steps,
+               maze.distance[(size_t)reader.row * maze.cols + reader.col]);
+    } else {
+        printf("❌ Invalid path: %s\n", reader.error);
+    }
+    maze_free(&maze);
+    return reached ? 0 : 1;
+}
+
+/*
+================================================================================
+    PATHFINDING
+    Shortest paths on maze grids: BFS, bidirectional BFS, A* and jump
+    point search, plus the distance field used to check submitted paths
+================================================================================
+*/
+
+const char* PATH_ALGORITHM_NAMES[PATH_ALGORITHM_COUNT] = {
+    "BFS", "Bidirectional BFS", "A*", "Jump point search"
+};
+
+const int PATH_DR[4] = { -1, 1, 0, 0 };
+const int PATH_DC[4] = { 0, 0, 1, -1 };
+
+// Expand one whole BFS level of one side; returns 1 when it touches the
+// other side's visited cells
+int path_expand_level(const Maze* maze, CellList* frontier, CellList* next,
+                      uint64_t* mine, const uint64_t* theirs, uint64_t* expanded, int* ok) {
+    int met = 0;
+    next->count = 0;
+    for(size_t i = 0; i < frontier->count && *ok; i++) {
+        int row = frontier->cells[i] / maze->cols;
+        int col = frontier->cells[i] % maze->cols;
+        (*expanded)++;
+        for(int d = 0; d < 4; d++) {
+            int r = row + PATH_DR[d];
+            int c = col + PATH_DC[d];
+            if (!maze_is_open(maze, r, c)) continue;
+            size_t index = maze_index(maze, r, c);
+            if (bit_test(theirs, index)) met = 1;
+            if (bit_test(mine, index)) continue;
+            bit_set(mine, index);
+            *ok = cell_list_push(next, (uint32_t)r * maze->cols + c);
+        }
+    }
+    CellList swap = *frontier;
+    *frontier = *next;
+    *next = swap;
+    return met;
+}
+
+// BFS from both ends at once, always growing the smaller frontier. The
+// first level that reaches the other side closes the shortest path.
+int path_bidirectional(const Maze* maze, uint64_t* expanded) {
+    size_t words = (size_t)maze->rows * maze->stride / 64;
+    uint64_t* seen[2] = { calloc(words, sizeof(uint64_t)), calloc(words, sizeof(uint64_t)) };
+    CellList frontier[2] = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+    CellList next = { NULL, 0, 0 };
+    int depth[2] = { 0, 0 };
+    int ok = seen[0] && seen[1] &&
+             cell_list_push(&frontier[0], 0) &&
+             cell_list_push(&frontier[1], (uint32_t)maze->goal_row * maze->cols + maze->goal_col);
+    
+    int length = -1;
+    if (ok) {
+        bit_set(seen[0], 0);
+        bit_set(seen[1], maze_index(maze, maze->goal_row, maze->goal_col));
+        if (maze->goal_row == 0 && maze->goal_col == 0) length = 0;
+    }
+    while (ok && length < 0 && frontier[0].count > 0 && frontier[1].count > 0) {
+        int side = frontier[0].count <= frontier[1].count ? 0 : 1;
+        int met = path_expand_level(maze, &frontier[side], &next, seen[side], seen[1 - side], expanded, &ok);
+        depth[side]++;
+        if (met) length = depth[0] + depth[1];
+    }
+    
+    free(seen[0]);
+    free(seen[1]);
+    free(frontier[0].cells);
+    free(frontier[1].cells);
+    free(next.cells);
+    return length;
+}
+
+// Binary min-heap of (priority << 32 | cell) for A* and jump point search
+int heap_push(HeapList* heap, uint64_t key) {
+    if (heap->count == heap->capacity) {
+        size_t capacity = heap->capacity ? heap->capacity * 2 : 1024;
+        uint64_t* keys = realloc(heap->keys, sizeof(uint64_t) * capacity);
+        if (!keys) return 0;
+        heap->keys = keys;
+        heap->capacity = capacity;
+    }
+    size_t i = heap->count++;
+    while (i > 0 && heap->keys[(i - 1) / 2] > key) {
+        heap->keys[i] = heap->keys[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->keys[i] = key;
+    return 1;
+}
+
+uint64_t heap_pop(HeapList* heap) {
+    uint64_t top = heap->keys[0];
+    uint64_t last = heap->keys[--heap->count];
+    size_t i = 0;
+    for(;;) {
+        size_t child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && heap->keys[child + 1] < heap->keys[child]) child++;
+        if (heap->keys[child] >= last) break;
+        heap->keys[i] = heap->keys[child];
+        i = child;
+    }
+    if (heap->count > 0) heap->keys[i] = last;
+    return top;
+}
+
+int path_heuristic(const Maze* maze, int row, int col) {
+    return abs(maze->goal_row - row) + abs(maze->goal_col - col);
+}
+
+// Jump from row,col in direction d until something interesting: the goal,
+// or for horizontal moves a forced turn (an opening above or below whose
+// cell one step back is walled). Vertical moves also stop wherever a
+// horizontal jump would find something. Returns the cell, or -1.
+int64_t path_jump(const Maze* maze, int row, int col, int d) {
+    int dr = PATH_DR[d], dc = PATH_DC[d];
+    for(;;) {
+        row += dr;
+        col += dc;
+        if (!maze_is_open(maze, row, col)) return -1;
+        if (row == maze->goal_row && col == maze->goal_col) break;
+        
+        if (dr == 0) {
+            if ((maze_is_open(maze, row - 1, col) && !maze_is_open(maze, row - 1, col - dc)) ||
+                (maze_is_open(maze, row + 1, col) && !maze_is_open(maze, row + 1, col - dc))) {
+                break;
+            }
+        } else if (path_jump(maze, row, col, 2) >= 0 || path_jump(maze, row, col, 3) >= 0) {
+            break;
+        }
+    }
+    return (int64_t)row * maze->cols + col;
+}
+
+// A* with the Manhattan heuristic. With jumps set, successors are jump
+// points instead of neighbours: straight runs are skipped in one step and
+// only cells where the route may turn enter the open list.
+int path_astar(const Maze* maze, int jumps, uint64_t* expanded) {
+    size_t cells = (size_t)maze->rows * maze->cols;
+    uint32_t* g = malloc(sizeof(uint32_t) * cells);
+    uint8_t* arrived = malloc(cells); // Direction each cell was reached in, 4 for the start
+    HeapList open = { NULL, 0, 0 };
+    int length = -1;
+    if (!g || !arrived) {
+        free(g);
+        free(arrived);
+        return -1;
+    }
+    memset(g, 0xff, sizeof(uint32_t) * cells);
+    
+    uint32_t goal = (uint32_t)maze->goal_row * maze->cols + maze->goal_col;
+    g[0] = 0;
+    arrived[0] = 4;
+    int ok = heap_push(&open, (uint64_t)path_heuristic(maze, 0, 0) << 32);
+    
+    while (ok && open.count > 0) {
+        uint64_t key = heap_pop(&open);
+        uint32_t cell = (uint32_t)key;
+        int row = cell / maze->cols;
+        int col = cell % maze->cols;
+        if ((key >> 32) != g[cell] + (uint64_t)path_heuristic(maze, row, col)) continue; // Stale entry
+        if (cell == goal) {
+            length = g[cell];
+            break;
+        }
+        (*expanded)++;
+        
+        for(int d = 0; d < 4; d++) {
+            int64_t next;
+            if (!jumps) {
+                next = maze_is_open(maze, row + PATH_DR[d], col + PATH_DC[d])
+                     ? (int64_t)(row + PATH_DR[d]) * maze->cols + col + PATH_DC[d] : -1;
+            } else {
+                // Prune to the directions a canonical route can take here
+                int from = arrived[cell];
+                int back = from == 4 ? -1 : from ^ 1;
+                if (d == back) continue;
+                if (from < 2 || from == 4) {
+                    // Arrived vertically (or the start): everything is natural
+                } else if (d < 2) {
+                    // Arrived horizontally: turn only where forced
+                    int behind = col - PATH_DC[from];
+                    if (!maze_is_open(maze, row + PATH_DR[d], col) ||
+                        maze_is_open(maze, row + PATH_DR[d], behind)) continue;
+                }
+                next = path_jump(maze, row, col, d);
+            }
+            if (next < 0) continue;
+            
+            int r = (int)(next / maze->cols);
+            int c = (int)(next % maze->cols);
+            uint32_t cost = g[cell] + abs(r - row) + abs(c - col);
+            if (cost < g[next]) {
+                g[next] = cost;
+                arrived[next] = d;
+                ok = heap_push(&open, ((uint64_t)(cost + path_heuristic(maze, r, c)) << 32) | (uint32_t)next);
+            }
+        }
+    }
+    
+    free(g);
+    free(arrived);
+    free(open.keys);
+    return length;
+}
+
+// Shortest path length with the chosen algorithm, counting expanded cells
+int path_search(const Maze* maze, PathAlgorithm algorithm, uint64_t* expanded) {
+    *expanded = 0;
+    switch (algorithm) {
+        case PATH_BFS:           return maze_shortest_path(maze, expanded);
+        case PATH_BIDIRECTIONAL: return path_bidirectional(maze, expanded);
+        case PATH_ASTAR:         return path_astar(maze, 0, expanded);
+        case PATH_JPS:           return path_astar(maze, 1, expanded);
+        default:                 return -1;
+    }
+}
+
+// --bench-paths SIZE [SEED] [ROUNDS]: time every algorithm on one maze
+int path_bench_main(int argc, char** argv) {
+    int size = argc > 2 ? atoi(argv[2]) : 1024;
+    unsigned long long seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    int rounds = argc > 4 ? atoi(argv[4]) : 3;
+    if (size < MAZE_MIN_SIZE || size > MAZE_MAX_SIZE || rounds < 1) {
+        printf("Usage: %s --bench-paths [SIZE] [SEED] [ROUNDS]\n", argv[0]);
+        return 2;
+    }
+    
+    Maze maze;
+    int64_t started = clock_now_ns();
+    if (!maze_generate(&maze, size, size, seed)) {
+        printf("❌ Not enough memory for a %dx%d maze.\n", size, size);
+        return 1;
+    }
+    printf("Maze %dx%d, seed %llu: generated with distance field in %.1f ms, shortest path %d\n",
+           size, size, seed, (double)(clock_now_ns() - started) / NS_PER_MS, maze.optimal);
+    printf("%-20s %10s %12s %12s\n", "Algorithm", "Length", "Expanded", "Best ms");
+    
+    int status = 0;
+    for(int a = 0; a < PATH_ALGORITHM_COUNT; a++) {
+        double best = -1;
+        uint64_t expanded = 0;
+        int length = -1;
+        for(int i = 0; i < rounds; i++) {
+            int64_t start = clock_now_ns();
+            length = path_search(&maze, a, &expanded);
+            double ms = (double)(clock_now_ns() - start) / NS_PER_MS;
+            if (best < 0 || ms < best) best = ms;
+        }
+        printf("%-20s %10d %12llu %12.2f%s\n", PATH_ALGORITHM_NAMES[a], length,
+               (unsigned long long)expanded, best, length == maze.optimal ? "" : "  ❌ mismatch");
+        if (length != maze.optimal) status = 1;
+    }
+    maze_free(&maze);
+    return status;
+}
+
+/*
+================================================================================
+    CHALLENGE 3: COURSE DE ROBOTS
+    Find the shortest path through a maze
+================================================================================
+*/
+
+// Draw the part of the maze starting at top,left that fits the viewport
+void display_maze(Session* s, const Maze* maze, int top, int left) {
+    int rows = maze->rows < MAZE_VIEW_ROWS ? maze->rows : MAZE_VIEW_ROWS;
+    int cols = maze->cols < MAZE_VIEW_COLS ? maze->cols : MAZE_VIEW_COLS;
+    int margin = snprintf(NULL, 0, "%d", maze->rows - 1);
+    
+    // Build each row in one go instead of one write per cell
+    char row[2 * MAZE_VIEW_COLS + 2];
+    for(int j = 0; j < cols; j++) {
+        row[2 * j] = '0' + (left + j) % 10;
+        row[2 * j + 1] = ' ';
+    }
+    row[2 * cols] = '\n';
+    row[2 * cols + 1] = '\0';
+    session_printf(s, "\n%*s %s", margin, "", row);
+    
+    for(int i = top; i < top + rows; i++) {
+        for(int j = 0; j < cols; j++) {
+            int col = left + j;
+            size_t index = maze_index(maze, i, col);
+            char cell = EMPTY;
+            if (i == 0 && col == 0) cell = START;
+            else if (i == maze->goal_row && col == maze->goal_col) cell = END;
+            else if (bit_test(maze->walls, index)) cell = WALL;
+            else if (bit_test(maze->trail, index)) cell = PATH;
+            row[2 * j] = cell;
+        }
+        session_printf(s, "%*d %s", margin, i, row);
+    }
+}
+
+// Keep the viewport inside the maze
+void robot_clamp_view(RobotGame* game) {
+    int max_row = game->maze.rows - MAZE_VIEW_ROWS;
+    int max_col = game->maze.cols - MAZE_VIEW_COLS;
+    if (game->view_row > max_row) game->view_row = max_row;
+    if (game->view_col > max_col) game->view_col = max_col;
+    if (game->view_row < 0) game->view_row = 0;
+    if (game->view_col < 0) game->view_col = 0;
+}
+
+// Draw the challenge screen; scrolling only rewrites the maze rows
+void robot_render(Session* s) {
+    RobotGame* game = &s->game.robot;
+    const Maze* maze = &game->maze;
+    int scrolls = maze->rows > MAZE_VIEW_ROWS || maze->cols > MAZE_VIEW_COLS;
+    
+    render_begin(s);
+    display_header(s, "CHALLENGE 3: Course de Robots");
+    
+    session_puts(s, "🎯 Objective: Find the shortest path from S to E\n");
+    session_puts(s, "   Commands: N (North/Up), S (South/Down), E (East/Right), O (West/Left)\n\n");
+    session_printf(s, "Maze %dx%d (seed %llu), goal at row %d, column %d\n", maze->rows, maze->cols,
+           (unsigned long long)maze->seed, maze->goal_row, maze->goal_col);
+    if (scrolls) {
+        session_printf(s, "Showing rows %d-%d, columns %d-%d: ^ v < > scroll, 'goto ROW COL' jumps\n",
+               game->view_row, game->view_row + MAZE_VIEW_ROWS - 1,
+               game->view_col, game->view_col + MAZE_VIEW_COLS - 1);
+    }
+    
+    display_maze(s, maze, game->view_row, game->view_col);
+    
+    session_printf(s, "\n%s\n", game->message);
+    session_puts(s, "Enter your path (e.g., SSEEENNNEE or S2E3N2E2), 'try PATH' to test it");
+    if (s->fd < 0) session_puts(s, ", 'file PATH'");
+    session_puts(s, " or 'skip': ");
+    render_commit(s);
+}
+
+void challenge_course_robots_start(Session* s) {
+    clear_screen(s);
+    display_header(s, "CHALLENGE 3: Course de Robots");
+    
+    session_printf(s, "🎯 Objective: Find the shortest path from S to E\n");
+    session_printf(s, "   Every maze is generated fresh; the same size and seed give the same maze\n\n");
+    session_printf(s, "Maze size (%d-%d, Enter for %d), optionally followed by a seed: ",
+           MAZE_MIN_SIZE, MAZE_MAX_SIZE, MAZE_DEFAULT_SIZE);
+    s->screen = SCREEN_ROBOT_SIZE;
+}
+
+void challenge_course_robots_size_input(Session* s, const char* input) {
+    RobotGame* game = &s->game.robot;
+    int size = MAZE_DEFAULT_SIZE;
+    unsigned long long seed = ((unsigned long long)rand() << 32) ^ ((unsigned long long)rand() << 16) ^ (unsigned long long)time(NULL);
+    
+    if (input[0] && sscanf(input, "%d %llu", &size, &seed) < 1) size = 0;
+    if (size < MAZE_MIN_SIZE || size > MAZE_MAX_SIZE) {
+        session_printf(s, "Maze size (%d-%d): ", MAZE_MIN_SIZE, MAZE_MAX_SIZE);
+        return;
+    }
+    
+    if (!maze_generate(&game->maze, size, size, seed)) {
+        session_printf(s, "\n❌ Not enough memory for a %dx%d maze.\n", size, size);
+        pause_screen(s);
+        return;
+    }
+    
+    game->view_row = 0;
+    game->view_col = 0;
+    game->message = "";
+    game->streaming = ROBOT_STREAM_NONE;
+    challenge_begin(s);
+    s->screen = SCREEN_ROBOT;
+    robot_render(s);
+}
+
+// Forget the last walked path before walking a new one
+void robot_reset_trail(RobotGame* game) {
+    memset(game->maze.trail, 0, (size_t)game->maze.rows * game->maze.stride / 8);
+    path_reader_init(&game->reader);
+}
+
+// Say how the path walked so far is doing, without ending the game: every
+// step was checked against the distance field, so nothing is solved again
+void robot_try_report(Session* s) {
+    RobotGame* game = &s->game.robot;
+    Maze* maze = &game->maze;
+    PathReader* reader = &game->reader;
+    
+    game->streaming = ROBOT_STREAM_NONE;
+    path_reader_finish(reader, maze);
+    uint32_t left = maze->distance[(size_t)reader->row * maze->cols + reader->col];
+    
+    if (!reader->valid) {
+        snprintf(game->feedback, sizeof(game->feedback), "❌ Invalid path: %s.", reader->error);
+    } else if (reader->detour_step < 0) {
+        snprintf(game->feedback, sizeof(game->feedback), "✅ %lld steps, all on a shortest route; %u to go.",
+                 reader->steps, left);
+    } else {
+        snprintf(game->feedback, sizeof(game->feedback),
+                 "⚠️  Off the shortest route since step %lld (from row %d, column %d): %lld detour steps, %u to go.",
+                 reader->detour_step, reader->detour_row, reader->detour_col, reader->detours, left);
+    }
+    game->message = game->feedback;
+    game->view_row = reader->row - MAZE_VIEW_ROWS / 2;
+    game->view_col = reader->col - MAZE_VIEW_COLS / 2;
+    robot_clamp_view(game);
+    robot_render(s);
+}
+
+void robot_try(Session* s, const char* path) {
+    RobotGame* game = &s->game.robot;
+    robot_reset_trail(game);
+    path_reader_feed(&game->reader, &game->maze, path, strlen(path));
+    robot_try_report(s);
+}
+
+// Leave the game, releasing the maze
+void robot_finish(Session* s) {
+    maze_free(&s->game.robot.maze);
+    pause_screen(s);
+}
+
+void robot_stream(Session* s, const char* data, size_t len);
+void robot_judge(Session* s);
+
+void challenge_course_robots_input(Session* s, const char* path) {
+    RobotGame* game = &s->game.robot;
+    Maze* maze = &game->maze;
+    
+    // The end of a line that was already streaming
+    switch(game->streaming) {
+        case ROBOT_STREAM_PATH:
+            robot_stream(s, path, strlen(path));
+            robot_judge(s);
+            return;
+        case ROBOT_STREAM_TRY:
+            robot_stream(s, path, strlen(path));
+            robot_try_report(s);
+            return;
+        case ROBOT_STREAM_IGNORE:
+            game->streaming = ROBOT_STREAM_NONE;
+            game->message = "❌ That line is too long for a command. Send a path, or 'try' and a path.";
+            robot_render(s);
+            return;
+        case ROBOT_STREAM_NONE:
+            break;
+    }
+    
+    if (strcmp(path, "skip") == 0) {
+        session_printf(s, "\n❌ Challenge skipped!\n");
+        challenge_record_attempt(s, CHALLENGE_ROBOT, 0, 0);
+        robot_finish(s);
+        return;
+    }
+    
+    // Viewport commands
+    int row, col;
+    game->message = "";
+    if (strlen(path) == 1 && strchr("^v<>", path[0])) {
+        switch (path[0]) {
+            case '^': game->view_row -= MAZE_VIEW_ROWS / 2; break;
+            case 'v': game->view_row += MAZE_VIEW_ROWS / 2; break;
+            case '<': game->view_col -= MAZE_VIEW_COLS / 2; break;
+            case '>': game->view_col += MAZE_VIEW_COLS / 2; break;
+        }
+        robot_clamp_view(game);
+        robot_render(s);
+        return;
+    }
+    if (sscanf(path, "goto %d %d", &row, &col) == 2) {
+        game->view_row = row - MAZE_VIEW_ROWS / 2;
+        game->view_col = col - MAZE_VIEW_COLS / 2;
+        robot_clamp_view(game);
+        robot_render(s);
+        return;
+    }
+    
+    if (strncmp(path, "try ", 4) == 0) {
+        robot_try(s, path + 4);
+        return;
+    }
     
-    // Simple validation: check if expression uses only allowed numbers
-    int used[6] = {0};
-    char temp[100];
-    int temp_idx = 0;
+    // A path read from a local file, for the terminal player only
+    if (strncmp(path, "file ", 5) == 0 && strcmp(path + 5, "-") != 0 && s->fd < 0) {
+        robot_reset_trail(game);
+        if (!path_reader_feed_file(&game->reader, maze, path + 5)) {
+            game->message = "❌ Could not read that file.";
+            robot_render(s);
+            return;
+        }
+        robot_judge(s);
+        return;
+    }
     
-    for(int i = 0; clean[i]; i++) {
-        if (isdigit(clean[i])) {
-            temp[temp_idx++] = clean[i];
+    robot_reset_trail(game);
+    path_reader_feed(&game->reader, maze, path, strlen(path));
+    robot_judge(s);
+}
+
+// Take the next part of a long line, before its end. The first part says
+// whether it is a path to judge, a 'try' to preview, or neither
+void robot_stream(Session* s, const char* data, size_t len) {
+    RobotGame* game = &s->game.robot;
+    if (game->streaming == ROBOT_STREAM_NONE) {
+        robot_reset_trail(game);
+        size_t start = 0;
+        while (start < len && isspace((unsigned char)data[start])) start++;
+        if (len - start >= 4 && strncmp(data + start, "try ", 4) == 0) {
+            game->streaming = ROBOT_STREAM_TRY;
+            data += start + 4;
+            len -= start + 4;
+        } else if (start < len && strchr("NSEOnseo", data[start])) {
+            game->streaming = ROBOT_STREAM_PATH;
         } else {
-            if (temp_idx > 0) {
-                temp[temp_idx] = '\0';
-                int num = atoi(temp);
-                int found = 0;
-                for(int j = 0; j < count; j++) {
-                    if (numbers[j] == num && !used[j]) {
-                        used[j] = 1;
-                        found = 1;
-                        break;
-                    }
-                }
-                if (!found) {
-                    *valid = 0;
-                    return 0;
+            game->streaming = ROBOT_STREAM_IGNORE;
+        }
+    }
+    if (game->streaming != ROBOT_STREAM_IGNORE) {
+        path_reader_feed(&game->reader, &game->maze, data, len);
+    }
+}
+
+// The whole path is in: score it
+void robot_judge(Session* s) {
+    RobotGame* game = &s->game.robot;
+    Maze* maze = &game->maze;
+    PathReader* reader = &game->reader;
+    long long optimal_path = maze->optimal;
+    
+    game->streaming = ROBOT_STREAM_NONE;
+    int valid = path_reader_finish(reader, maze);
+    int x = reader->row, y = reader->col;
+    long long steps = reader->steps;
+    
+    // Show where the robot ended up
+    game->view_row = x - MAZE_VIEW_ROWS / 2;
+    game->view_col = y - MAZE_VIEW_COLS / 2;
+    robot_clamp_view(game);
+    
+    if (valid && x == maze->goal_row && y == maze->goal_col) {
+        session_printf(s, "\n✅ You reached the end!\n");
+        display_maze(s, maze, game->view_row, game->view_col);
+        
+        // Score based on path length (shorter is better)
+        long long extra = steps - optimal_path;
+        int score = extra < POINTS_ROBOT - 10 ? POINTS_ROBOT - (int)extra : 10;
+        
+        session_printf(s, "\n🎯 Path length: %lld steps (shortest: %lld)\n", steps, optimal_path);
+        if (reader->detour_step >= 0) {
+            session_printf(s, "↪️  Left the shortest route on step %lld, at row %d, column %d\n",
+                           reader->detour_step, reader->detour_row, reader->detour_col);
+        }
+        session_printf(s, "🎯 Score earned: %d points\n", score);
+        
+        challenge_record_attempt(s, CHALLENGE_ROBOT, score, steps);
+    } else {
+        if (!valid) {
+            session_printf(s, "\n❌ Invalid path: %s.\n", reader->error);
+        } else {
+            session_printf(s, "\n❌ The path stops at row %d, column %d, %u steps from the end.\n",
+                           x, y, maze->distance[(size_t)x * maze->cols + y]);
+        }
+        display_maze(s, maze, game->view_row, game->view_col);
+        challenge_record_attempt(s, CHALLENGE_ROBOT, 0, steps);
+    }
+    
+    robot_finish(s);
+}
+
+/*
+================================================================================
+    SORTING ENGINE
+    Optimal operation counts for Tri Ultime under each operation model
+================================================================================
+*/
+
+const TriModelInfo TRI_MODELS[TRI_MODEL_COUNT] = {
+    { "Swap",            "Swap any two elements",           "index1 index2, e.g., 0 5", TRI_MAX_SIZE },
+    { "Adjacent swap",   "Swap two neighbouring elements",  "index, swapped with the next", TRI_MAX_SIZE },
+    { "Prefix reversal", "Reverse the first k elements",    "k, e.g., 4",               TRI_REVERSAL_MAX_SIZE }
+};
+
+int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Rank of every element (0 for the smallest); the values are distinct.
+// Returns NULL when out of memory.
+int* tri_ranks(const int* arr, int n) {
+    uint64_t* keys = malloc(sizeof(uint64_t) * n);
+    int* rank = malloc(sizeof(int) * n);
+    if (!keys || !rank) {
+        free(keys);
+        free(rank);
+        return NULL;
+    }
+    // Values are non-negative, so (value, index) sorts as one integer
+    for(int i = 0; i < n; i++) keys[i] = (uint64_t)(uint32_t)arr[i] << 32 | (uint32_t)i;
+    qsort(keys, n, sizeof(uint64_t), compare_u64);
+    for(int i = 0; i < n; i++) rank[(uint32_t)keys[i]] = i;
+    free(keys);
+    return rank;
+}
+
+// Any two elements: every cycle of the permutation of length L takes L-1
+// swaps, so the optimum is n minus the number of cycles
+long long tri_min_swaps(const int* rank, int n) {
+    uint8_t* seen = calloc(n, 1);
+    if (!seen) return -1;
+    long long cycles = 0;
+    for(int i = 0; i < n; i++) {
+        if (seen[i]) continue;
+        cycles++;
+        for(int j = i; !seen[j]; j = rank[j]) seen[j] = 1;
+    }
+    free(seen);
+    return n - cycles;
+}
+
+// Neighbours only: each swap removes at most one inversion, and bubble sort
+// shows one is always removable. Inversions are counted left to right with
+// a Fenwick tree over ranks already seen.
+long long tri_inversions(const int* rank, int n) {
+    int* tree = calloc(n + 1, sizeof(int));
+    if (!tree) return -1;
+    long long inversions = 0;
+    for(int i = 0; i < n; i++) {
+        int smaller = 0;
+        for(int j = rank[i] + 1; j > 0; j -= j & -j) smaller += tree[j];
+        inversions += i - smaller;
+        for(int j = rank[i] + 1; j <= n; j += j & -j) tree[j]++;
+    }
+    free(tree);
+    return inversions;
+}
+
+void tri_reverse(int* arr, int k) {
+    for(int i = 0, j = k - 1; i < j; i++, j--) {
+        int temp = arr[i];
+        arr[i] = arr[j];
+        arr[j] = temp;
+    }
+}
+
+// Neighbours in the stack that are not consecutive ranks; the plate under
+// the stack has rank n. A flip changes at most one of these.
+int tri_gap(const int* p, int i) {
+    return abs(p[i] - p[i + 1]) != 1;
+}
+
+// Depth-first part of IDA*: 1 once sorted within bound flips
+int tri_flip_search(int* p, int n, int depth, int bound, int gaps, int last, int* next_bound) {
+    if (gaps == 0) return 1;
+    if (depth + gaps > bound) {
+        if (depth + gaps < *next_bound) *next_bound = depth + gaps;
+        return 0;
+    }
+    for(int k = 2; k <= n; k++) {
+        if (k == last) continue;
+        // Only the gap below the flipped prefix changes
+        int before = tri_gap(p, k - 1);
+        int after = abs(p[0] - p[k]) != 1;
+        tri_reverse(p, k);
+        int found = tri_flip_search(p, n, depth + 1, bound, gaps - before + after, k, next_bound);
+        tri_reverse(p, k);
+        if (found) return 1;
+    }
+    return 0;
+}
+
+// Prefix reversals (pancake sorting) is NP-hard. Small stacks are solved
+// exactly with IDA* on the gap count, which never overestimates; larger
+// ones get the flips of the place-the-largest strategy as an upper bound.
+long long tri_min_reversals(const int* rank, int n, int* exact) {
+    int* p = malloc(sizeof(int) * (n + 1));
+    if (!p) return -1;
+    memcpy(p, rank, sizeof(int) * n);
+    p[n] = n;
+    
+    long long flips = 0;
+    *exact = n <= TRI_REVERSAL_EXACT_MAX;
+    if (*exact) {
+        int gaps = 0;
+        for(int i = 0; i < n; i++) gaps += tri_gap(p, i);
+        int bound = gaps;
+        for(;;) {
+            int next_bound = INT32_MAX;
+            if (tri_flip_search(p, n, 0, bound, gaps, 0, &next_bound)) break;
+            bound = next_bound;
+        }
+        flips = bound;
+    } else {
+        for(int size = n; size > 1; size--) {
+            int top = 0;
+            while (p[top] != size - 1) top++;
+            if (top == size - 1) continue;
+            if (top > 0) {
+                tri_reverse(p, top + 1);
+                flips++;
+            }
+            tri_reverse(p, size);
+            flips++;
+        }
+    }
+    free(p);
+    return flips;
+}
+
+// Fewest operations that sort arr under a model, or -1 when out of memory.
+// exact is cleared when only an upper bound is known.
+long long tri_optimal(const int* arr, int n, TriModel model, int* exact) {
+    int* rank = tri_ranks(arr, n);
+    if (!rank) return -1;
+    long long cost = -1;
+    *exact = 1;
+    switch (model) {
+        case TRI_SWAP:     cost = tri_min_swaps(rank, n); break;
+        case TRI_ADJACENT: cost = tri_inversions(rank, n); break;
+        case TRI_REVERSAL: cost = tri_min_reversals(rank, n, exact); break;
+        default: break;
+    }
+    free(rank);
+    return cost;
+}
+
+/*
+================================================================================
+    CHALLENGE 4: TRI ULTIME
+    Sort an array with limited operations
+================================================================================
+*/
+
+// Print up to TRI_SHOW_MAX elements of an array
+void tri_print(Session* s, const int* arr, int n) {
+    int shown = n < TRI_SHOW_MAX ? n : TRI_SHOW_MAX;
+    for(int i = 0; i < shown; i++) {
+        session_printf(s, "%d ", arr[i]);
+    }
+    if (shown < n) session_printf(s, "... (%d more)", n - shown);
+}
+
+// Draw the whole challenge screen; after the first frame only the rows a
+// swap changed are rewritten
+void tri_render(Session* s, const char* prompt) {
+    TriGame* game = &s->game.tri;
+    const TriModelInfo* model = &TRI_MODELS[game->model];
+    render_begin(s);
+    display_header(s, "CHALLENGE 4: Tri Ultime");
+    
+    session_printf(s, "🎯 Objective: Sort the %d elements with as few operations as possible\n", game->n);
+    session_printf(s, "   Operation: %s (%s); the best is %s%lld\n\n", model->name, model->description,
+           game->exact ? "" : "at most ", game->optimal);
+    
+    session_puts(s, "Initial array: ");
+    tri_print(s, game->initial, game->n);
+    session_puts(s, "\n\n");
+    
+    session_printf(s, "Enter operations (format: %s), several per line with ';' between\n", model->format);
+    session_puts(s, "Type 'done' when finished, 'skip' to skip");
+    if (game->n > TRI_VIEW_ROWS * TRI_ROW_ELEMENTS) session_puts(s, ", 'goto INDEX' to look around");
+    if (s->fd < 0) session_puts(s, ", 'save PATH' to write the array out, 'file PATH' to apply a list");
+    session_puts(s, "\n\n");
+    
+    // One screen row per block of elements, so a swap rewrites at most two
+    session_puts(s, "Current array:\n");
+    int width = snprintf(NULL, 0, "%d", game->n - 1);
+    for(int row = 0; row < TRI_VIEW_ROWS; row++) {
+        int first = game->view + row * TRI_ROW_ELEMENTS;
+        if (first >= game->n) break;
+        session_printf(s, "  [%*d] ", width, first);
+        for(int i = first; i < first + TRI_ROW_ELEMENTS && i < game->n; i++) {
+            session_printf(s, "%d ", game->arr[i]);
+        }
+        session_puts(s, "\n");
+    }
+    session_printf(s, "Moves: %lld, pairs out of order: %lld\n", game->moves, game->descents);
+    session_printf(s, "%s\n", game->message);
+    
+    session_puts(s, prompt);
+    render_commit(s);
+}
+
+void tri_free(TriGame* game) {
+    free(game->arr);
+    free(game->initial);
+    game->arr = NULL;
+    game->initial = NULL;
+}
+
+// Leave the game, releasing the arrays
+void tri_finish(Session* s) {
+    tri_free(&s->game.tri);
+    pause_screen(s);
+}
+
+// Wide enough for a million-element shuffle even where RAND_MAX is 32767
+size_t tri_random(size_t bound) {
+    return (((size_t)rand() << 30) ^ ((size_t)rand() << 15) ^ (size_t)rand()) % bound;
+}
+
+void challenge_tri_ultime_start(Session* s) {
+    clear_screen(s);
+    display_header(s, "CHALLENGE 4: Tri Ultime");
+    
+    session_printf(s, "🎯 Objective: Sort the array in as few operations as possible\n");
+    session_printf(s, "   Scored against the true optimum for the chosen operation\n\n");
+    for(int i = 0; i < TRI_MODEL_COUNT; i++) {
+        session_printf(s, "%d. %s: %s (up to %d elements)\n", i + 1, TRI_MODELS[i].name,
+               TRI_MODELS[i].description, TRI_MODELS[i].max_size);
+    }
+    session_printf(s, "\nChoose an operation, optionally followed by a size (Enter for 1 %d): ", TRI_DEFAULT_SIZE);
+    s->screen = SCREEN_TRI_SETUP;
+}
+
+void challenge_tri_ultime_setup_input(Session* s, const char* input) {
+    TriGame* game = &s->game.tri;
+    int model = 1, n = TRI_DEFAULT_SIZE;
+    if (input[0] && sscanf(input, "%d %d", &model, &n) < 1) model = 0;
+    model--;
+    if (model < 0 || model >= TRI_MODEL_COUNT || n < TRI_MIN_SIZE || n > TRI_MODELS[model].max_size) {
+        session_printf(s, "Choose an operation (1-%d) and a size (%d or more): ", TRI_MODEL_COUNT, TRI_MIN_SIZE);
+        return;
+    }
+    
+    // Distinct values: 10-99 as before, or a shuffle of more values for
+    // arrays too large for that range
+    int range = n <= 90 ? 90 : n;
+    int* pool = malloc(sizeof(int) * range);
+    game->arr = malloc(sizeof(int) * n);
+    game->initial = malloc(sizeof(int) * n);
+    if (!pool || !game->arr || !game->initial) {
+        free(pool);
+        session_printf(s, "\n❌ Not enough memory for %d elements.\n", n);
+        tri_finish(s);
+        return;
+    }
+    for(int i = 0; i < range; i++) pool[i] = i + 10;
+    for(int i = 0; i < n; i++) {
+        int j = i + (int)tri_random(range - i);
+        int temp = pool[i];
+        pool[i] = pool[j];
+        pool[j] = temp;
+        game->arr[i] = pool[i];
+    }
+    free(pool);
+    
+    game->n = n;
+    game->model = model;
+    game->optimal = tri_optimal(game->arr, n, model, &game->exact);
+    if (game->optimal == 0) {
+        // Already sorted: give the player something to do
+        tri_reverse(game->arr, n);
+        game->optimal = tri_optimal(game->arr, n, model, &game->exact);
+    }
+    if (game->optimal < 0) {
+        session_printf(s, "\n❌ Not enough memory for %d elements.\n", n);
+        tri_finish(s);
+        return;
+    }
+    memcpy(game->initial, game->arr, sizeof(int) * n);
+    
+    game->descents = 0;
+    for(int i = 0; i + 1 < n; i++) game->descents += game->arr[i] > game->arr[i + 1];
+    game->moves = 0;
+    game->view = 0;
+    game->streaming = 0;
+    game->message = "";
+    challenge_begin(s);
+    s->screen = SCREEN_TRI;
+    tri_render(s, "Move (or 'done'/'skip'): ");
+}
+
+// Whether the neighbours at i and i+1 are out of order (0 past the end)
+int tri_descent(const TriGame* game, int i) {
+    return i >= 0 && i + 1 < game->n && game->arr[i] > game->arr[i + 1];
+}
+
+// Swap two elements; only the up to four neighbour pairs around them can
+// change, so the descent count follows in O(1)
+void tri_swap(TriGame* game, int a, int b) {
+    int pairs[4];
+    int count = 0;
+    int around[4] = { a - 1, a, b - 1, b };
+    for(int i = 0; i < 4; i++) {
+        int seen = 0;
+        for(int j = 0; j < count; j++) seen |= pairs[j] == around[i];
+        if (!seen) pairs[count++] = around[i];
+    }
+    for(int i = 0; i < count; i++) game->descents -= tri_descent(game, pairs[i]);
+    int temp = game->arr[a];
+    game->arr[a] = game->arr[b];
+    game->arr[b] = temp;
+    for(int i = 0; i < count; i++) game->descents += tri_descent(game, pairs[i]);
+}
+
+// Reverse a prefix; the flip itself is O(k), and so is recounting it
+void tri_flip(TriGame* game, int k) {
+    for(int i = 0; i < k; i++) game->descents -= tri_descent(game, i);
+    tri_reverse(game->arr, k);
+    for(int i = 0; i < k; i++) game->descents += tri_descent(game, i);
+}
+
+// Apply one operation; 0 if it is not valid for the model
+int tri_apply(TriGame* game, const long long* fields, int count) {
+    long long a = fields[0];
+    long long b = count > 1 ? fields[1] : a + 1;
+    int n = game->n;
+    
+    switch (game->model) {
+        case TRI_SWAP:
+            if (count < 2 || a >= n || b >= n) return 0;
+            if (a != b) tri_swap(game, (int)a, (int)b);
+            break;
+        case TRI_ADJACENT:
+            if (count > 1 || a + 1 >= n) return 0;
+            tri_swap(game, (int)a, (int)b);
+            break;
+        case TRI_REVERSAL:
+            if (count > 1 || a < 2 || a > n) return 0;
+            tri_flip(game, (int)a);
+            break;
+        default:
+            return 0;
+    }
+    game->moves++;
+    game->view = (int)a;
+    return 1;
+}
+
+void tri_reader_init(TriReader* reader) {
+    memset(reader, 0, sizeof(*reader));
+    reader->valid = 1;
+}
+
+// The number in progress is complete; apply the operation once it has all
+// its numbers, or earlier when a separator ends it
+void tri_reader_close(TriReader* reader, TriGame* game, int end_operation) {
+    if (reader->digits > 0) {
+        reader->count++;
+        reader->digits = 0;
+    }
+    int arity = game->model == TRI_SWAP ? 2 : 1;
+    if (reader->count == 0 || (reader->count < arity && !end_operation)) return;
+    
+    if (!tri_apply(game, reader->fields, reader->count)) {
+        reader->valid = 0;
+        snprintf(reader->error, sizeof(reader->error), "operation %lld is not valid",
+                 reader->applied + 1);
+        return;
+    }
+    reader->applied++;
+    reader->count = 0;
+    reader->fields[0] = reader->fields[1] = 0;
+}
+
+// Consume the next chunk of operations; returns 0 once one is invalid
+int tri_reader_feed(TriReader* reader, TriGame* game, const char* data, size_t len) {
+    for(size_t i = 0; i < len && reader->valid; i++) {
+        char c = data[i];
+        if (isdigit((unsigned char)c)) {
+            long long* field = &reader->fields[reader->count];
+            *field = *field * 10 + (c - '0');
+            if (*field > TRI_MAX_SIZE) *field = TRI_MAX_SIZE; // Invalid either way
+            reader->digits++;
+        } else if (c == ',' || c == ';' || c == '\n' || c == '\r') {
+            tri_reader_close(reader, game, 1);
+        } else if (isspace((unsigned char)c)) {
+            tri_reader_close(reader, game, 0);
+        } else {
+            reader->valid = 0;
+            snprintf(reader->error, sizeof(reader->error), "unexpected '%c' after %lld operations", c, reader->applied);
+        }
+    }
+    return reader->valid;
+}
+
+// The batch is complete: apply the last operation
+int tri_reader_finish(TriReader* reader, TriGame* game) {
+    if (reader->valid) tri_reader_close(reader, game, 1);
+    return reader->valid;
+}
+
+// Feed a whole file of operations through a reader
+int tri_reader_feed_file(TriReader* reader, TriGame* game, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+    
+    char* chunk = malloc(PATH_READ_CHUNK);
+    size_t n;
+    while (chunk && reader->valid && (n = fread(chunk, 1, PATH_READ_CHUNK, file)) > 0) {
+        tri_reader_feed(reader, game, chunk, n);
+    }
+    free(chunk);
+    fclose(file);
+    return chunk != NULL;
+}
+
+// Keep the view inside the array, aligned to whole rows
+void tri_clamp_view(TriGame* game) {
+    int last = game->n - TRI_VIEW_ROWS * TRI_ROW_ELEMENTS;
+    if (game->view > last) game->view = last;
+    if (game->view < 0) game->view = 0;
+    game->view -= game->view % TRI_ROW_ELEMENTS;
+}
+
+// Take the next part of a batch; long batches arrive in several parts,
+// before the end of the line
+void tri_stream(Session* s, const char* data, size_t len) {
+    TriGame* game = &s->game.tri;
+    if (!game->streaming) {
+        tri_reader_init(&game->reader);
+        game->streaming = 1;
+    }
+    tri_reader_feed(&game->reader, game, data, len);
+}
+
+// A batch is complete: say how it went and redraw
+void tri_batch_done(Session* s) {
+    TriGame* game = &s->game.tri;
+    TriReader* reader = &game->reader;
+    game->streaming = 0;
+    tri_reader_finish(reader, game);
+    
+    if (!reader->valid) {
+        snprintf(game->feedback, sizeof(game->feedback), "❌ Invalid: %s; %lld applied before it.",
+                 reader->error, reader->applied);
+    } else if (reader->applied > 1) {
+        snprintf(game->feedback, sizeof(game->feedback), "✅ %lld operations applied.", reader->applied);
+    } else {
+        game->feedback[0] = '\0';
+    }
+    game->message = game->feedback;
+    tri_clamp_view(game);
+    tri_render(s, "Move (or 'done'/'skip'): ");
+}
+
+void challenge_tri_ultime_input(Session* s, const char* input) {
+    TriGame* game = &s->game.tri;
+    
+    if (strcmp(input, "skip") == 0) {
+        session_printf(s, "\n❌ Challenge skipped!\n");
+        challenge_record_attempt(s, CHALLENGE_TRI, 0, game->moves);
+        tri_finish(s);
+        return;
+    }
+    
+    // The end of a batch that was already streaming
+    if (game->streaming) {
+        tri_stream(s, input, strlen(input));
+        tri_batch_done(s);
+        return;
+    }
+    
+    int index;
+    if (sscanf(input, "goto %d", &index) == 1) {
+        game->view = index;
+        game->message = "";
+        tri_clamp_view(game);
+        tri_render(s, "Move (or 'done'/'skip'): ");
+        return;
+    }
+    
+    // The current array, one number per line, for the terminal player only
+    if (strncmp(input, "save ", 5) == 0 && s->fd < 0) {
+        FILE* file = fopen(input + 5, "w");
+        if (file) {
+            for(int i = 0; i < game->n; i++) fprintf(file, "%d\n", game->arr[i]);
+            fclose(file);
+        }
+        game->message = file ? "✅ Array saved." : "❌ Could not write that file.";
+        tri_render(s, "Move (or 'done'/'skip'): ");
+        return;
+    }
+    
+    // A list of operations from a local file, for the terminal player only
+    if (strncmp(input, "file ", 5) == 0 && s->fd < 0) {
+        tri_reader_init(&game->reader);
+        if (!tri_reader_feed_file(&game->reader, game, input + 5)) {
+            game->message = "❌ Could not read that file.";
+            tri_render(s, "Move (or 'done'/'skip'): ");
+            return;
+        }
+        tri_batch_done(s);
+        return;
+    }
+    
+    if (strcmp(input, "done") != 0) {
+        tri_stream(s, input, strlen(input));
+        tri_batch_done(s);
+        return;
+    }
+    
+    if (game->descents == 0) {
+        // Full points at the optimum, falling towards the minimum as the
+        // move count grows past it
+        long long moves = game->moves;
+        int score = POINTS_TRI;
+        if (moves > game->optimal) {
+            score = TRI_MIN_SCORE + (int)((POINTS_TRI - TRI_MIN_SCORE) * game->optimal / moves);
+        }
+        
+        session_printf(s, "\n✅ Array sorted successfully!\n");
+        session_printf(s, "🎯 Number of moves: %lld (%s: %lld)\n", moves,
+               game->exact ? "optimal" : "best known", game->optimal);
+        session_printf(s, "🎯 Score earned: %d points\n", score);
+        
+        challenge_record_attempt(s, CHALLENGE_TRI, score, moves);
+    } else {
+        session_printf(s, "\n❌ Array is not sorted correctly!\n");
+        challenge_record_attempt(s, CHALLENGE_TRI, 0, game->moves);
+    }
+    
+    tri_finish(s);
+}
+
+/*
+================================================================================
+    HANOI ENGINE
+    Optimal move counts and reference solutions for 3 to 8 pegs
+================================================================================
+*/
+
+uint64_t saturating_add(uint64_t a, uint64_t b) {
+    return a + b < a ? UINT64_MAX : a + b;
+}
+
+// Frame-Stewart: park the top k disks using every peg, move the other
+// n-k with one peg fewer, then bring the k back on top. The best k for
+// each n and p is kept so solutions can be replayed. Proven optimal for
+// 3 and 4 pegs, conjectured beyond.
+void hanoi_table_init() {
+    hanoi_min_moves[1][2] = 1; // Two pegs move a single disk, the middle step with three
+    for(int p = 3; p <= HANOI_MAX_PEGS; p++) {
+        hanoi_min_moves[0][p] = 0;
+        for(int n = 1; n <= HANOI_MAX_DISKS; n++) {
+            if (p == 3) {
+                hanoi_min_moves[n][p] = n == 64 ? UINT64_MAX : (1ull << n) - 1;
+                hanoi_split[n][p] = n - 1;
+                continue;
+            }
+            uint64_t best = UINT64_MAX;
+            int best_k = 0;
+            for(int k = 0; k < n; k++) {
+                uint64_t parked = hanoi_min_moves[k][p];
+                uint64_t moves = saturating_add(saturating_add(parked, parked), hanoi_min_moves[n - k][p - 1]);
+                if (moves < best) {
+                    best = moves;
+                    best_k = k;
                 }
-                temp_idx = 0;
             }
+            hanoi_min_moves[n][p] = best;
+            hanoi_split[n][p] = best_k;
+        }
+    }
+}
+
+// Move m (from 0) of the reference solution taking n disks from order[0]
+// to order[1] over count pegs; order[2..] are the spare pegs. Each level
+// of the recursion drops into one of its three phases, so this is O(n).
+void hanoi_reference_move(int n, int count, uint64_t m, int* from, int* to) {
+    int order[HANOI_MAX_PEGS];
+    for(int i = 0; i < count; i++) order[i] = i;
+    order[1] = count - 1;
+    order[count - 1] = 1;
+    
+    for(;;) {
+        int k = hanoi_split[n][count];
+        uint64_t parked = hanoi_min_moves[k][count];
+        int spare = order[2];
+        if (m < parked) {
+            // Park k disks on the first spare, the target acting as a spare
+            order[2] = order[1];
+            order[1] = spare;
+            n = k;
+        } else if ((m -= parked) < hanoi_min_moves[n - k][count - 1]) {
+            // The rest go to the target without the parking peg
+            if (n - k == 1) break;
+            for(int i = 2; i < count - 1; i++) order[i] = order[i + 1];
+            n -= k;
+            count--;
+        } else {
+            // Bring the parked disks over from their spare
+            m -= hanoi_min_moves[n - k][count - 1];
+            order[2] = order[0];
+            order[0] = spare;
+            n = k;
+        }
+    }
+    *from = order[0];
+    *to = order[1];
+}
+
+// Peg masks after k moves of the optimal 3-peg solution from A to C, in O(n).
+// Disk d moves every 2^d moves, first at move 2^(d-1), so it has moved
+// round(k / 2^d) times; it always turns the same way round the pegs,
+// A->C->B when n-d is even and A->B->C otherwise.
+void hanoi_optimal_state(int disks, uint64_t k, uint64_t pegs[3]) {
+    pegs[0] = pegs[1] = pegs[2] = 0;
+    for(int d = 1; d <= disks; d++) {
+        uint64_t moved = (d < 64 ? k >> d : 0) + ((k >> (d - 1)) & 1);
+        int step = (disks - d) % 2 == 0 ? 2 : 1;
+        pegs[(moved % 3) * step % 3] |= 1ull << (d - 1);
+    }
+}
+
+/*
+================================================================================
+    CHALLENGE 5: TOUR DE HANOI
+    Solve the Tower of Hanoi puzzle
+================================================================================
+*/
+
+// Move the top disk of one peg onto another: legal when the source has a
+// disk and its lowest bit is below the target's lowest bit. With more
+// than three pegs the move is also compared with the reference solution,
+// for as long as the player follows it.
+int hanoi_move(HanoiGame* game, int from, int to) {
+    uint64_t disk = game->pegs[from] & -game->pegs[from];
+    uint64_t top = game->pegs[to] & -game->pegs[to];
+    if (from == to || !disk || (top && top < disk)) return 0;
+    if (game->on_track && game->peg_count > 3) {
+        int ref_from, ref_to;
+        game->on_track = game->moves < game->min_moves;
+        if (game->on_track) {
+            hanoi_reference_move(game->disks, game->peg_count, game->moves, &ref_from, &ref_to);
+            game->on_track = ref_from == from && ref_to == to;
         }
     }
-    if (temp_idx > 0) {
-        temp[temp_idx] = '\0';
-        int num = atoi(temp);
-        int found = 0;
-        for(int j = 0; j < count; j++) {
-            if (numbers[j] == num && !used[j]) {
-                used[j] = 1;
-                found = 1;
+    game->pegs[from] ^= disk;
+    game->pegs[to] |= disk;
+    game->moves++;
+    return 1;
+}
+
+void hanoi_reader_init(HanoiReader* reader) {
+    memset(reader, 0, sizeof(*reader));
+    reader->valid = 1;
+}
+
+// Consume the next chunk of moves; returns 0 once one is invalid
+int hanoi_reader_feed(HanoiReader* reader, HanoiGame* game, const char* data, size_t len) {
+    for(size_t i = 0; i < len && reader->valid; i++) {
+        char c = toupper((unsigned char)data[i]);
+        if (c >= 'A' && c < 'A' + game->peg_count) {
+            if (!reader->from) {
+                reader->from = c;
+                continue;
+            }
+            int from = reader->from - 'A';
+            reader->from = 0;
+            if (!hanoi_move(game, from, c - 'A')) {
+                reader->valid = 0;
+                snprintf(reader->error, sizeof(reader->error), "Move %llu (%c to %c): %s",
+                         (unsigned long long)reader->applied + 1, from + 'A', c,
+                         !game->pegs[from] ? "source tower is empty" :
+                         from == c - 'A' ? "same tower" : "cannot place larger disk on smaller disk");
                 break;
             }
+            reader->applied++;
+        } else if (!isspace((unsigned char)c) && !strchr(",;->", c)) {
+            reader->valid = 0;
+            snprintf(reader->error, sizeof(reader->error), "Unexpected '%c' after %llu moves",
+                     data[i], (unsigned long long)reader->applied);
         }
-        if (!found) {
-            *valid = 0;
-            return 0;
+    }
+    return reader->valid;
+}
+
+// The batch is complete: a lone peg letter is an unfinished move
+int hanoi_reader_finish(HanoiReader* reader) {
+    if (reader->valid && reader->from) {
+        reader->valid = 0;
+        snprintf(reader->error, sizeof(reader->error), "Move %llu has only one tower",
+                 (unsigned long long)reader->applied + 1);
+    }
+    return reader->valid;
+}
+
+// Feed a whole file of moves through a reader
+int hanoi_reader_feed_file(HanoiReader* reader, HanoiGame* game, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+    
+    char* chunk = malloc(PATH_READ_CHUNK);
+    size_t n;
+    while (chunk && reader->valid && (n = fread(chunk, 1, PATH_READ_CHUNK, file)) > 0) {
+        hanoi_reader_feed(reader, game, chunk, n);
+    }
+    free(chunk);
+    fclose(file);
+    return chunk != NULL;
+}
+
+// Whether the pegs are where the reference solution has them after the
+// same number of moves: by the closed form for three pegs, otherwise as
+// tracked move by move
+int hanoi_on_track(const HanoiGame* game) {
+    if (game->peg_count > 3) return game->on_track;
+    uint64_t optimal[3];
+    hanoi_optimal_state(game->disks, game->moves, optimal);
+    return game->moves <= game->min_moves && memcmp(optimal, game->pegs, sizeof(optimal)) == 0;
+}
+
+void display_hanoi_state(Session* s, const uint64_t* pegs, int peg_count, int disks) {
+    session_puts(s, "\n");
+    if (disks > HANOI_DRAW_MAX) {
+        // Too wide to draw: how many disks each peg holds and its top one
+        for(int tower = 0; tower < peg_count; tower++) {
+            int count = 0;
+            for(uint64_t bits = pegs[tower]; bits; bits &= bits - 1) count++;
+            session_printf(s, "  %c: %2d disk%s", 'A' + tower, count, count == 1 ? " " : "s");
+            if (count) {
+                int top = 1;
+                while (!(pegs[tower] >> (top - 1) & 1)) top++;
+                session_printf(s, ", top disk %d", top);
+            }
+            session_puts(s, "\n");
+        }
+        return;
+    }
+    
+    // Disks on a peg from the bottom (largest) up
+    int towers[HANOI_MAX_PEGS][HANOI_DRAW_MAX];
+    int counts[HANOI_MAX_PEGS] = { 0 };
+    for(int tower = 0; tower < peg_count; tower++) {
+        for(int d = disks; d >= 1; d--) {
+            if (pegs[tower] >> (d - 1) & 1) towers[tower][counts[tower]++] = d;
         }
     }
     
-    *valid = 1;
-    return atoi(clean + strlen(clean) - 3); // Gets last number as result
+    for(int level = disks - 1; level >= 0; level--) {
+        session_puts(s, "  ");
+        for(int tower = 0; tower < peg_count; tower++) {
+            int disk = counts[tower] > level ? towers[tower][level] : 0;
+            session_repeat(s, "█", disk);
+            session_repeat(s, " ", disks - disk + 2);
+        }
+        session_puts(s, "\n");
+    }
+    session_puts(s, "  ");
+    for(int tower = 0; tower < peg_count; tower++) {
+        session_repeat(s, "═", disks);
+        session_puts(s, tower < peg_count - 1 ? "  " : "\n");
+    }
+    session_puts(s, "  ");
+    for(int tower = 0; tower < peg_count; tower++) {
+        session_printf(s, "%*s%c%*s", (disks - 1) / 2, "", 'A' + tower, disks - (disks - 1) / 2 + 1, "");
+    }
+    session_puts(s, "\n");
 }
 
-void challenge_compte_bon() {
-    clear_screen();
-    display_header("CHALLENGE 1: Le Compte est Bon");
+// Draw the whole challenge screen; after the first frame a move only
+// rewrites the tower rows it touched and the move counter
+void hanoi_render(Session* s, const char* prompt) {
+    HanoiGame* game = &s->game.hanoi;
+    render_begin(s);
+    display_header(s, "CHALLENGE 5: Tour de Hanoi");
     
-    printf("🎯 Objective: Reach the target number using the given numbers\n");
-    printf("   You can use +, -, *, / operations\n");
-    printf("   Each number can be used only once\n\n");
+    session_printf(s, "🎯 Objective: Move all disks from tower A to tower %c\n", 'A' + game->peg_count - 1);
+    session_puts(s, "   Rules:\n");
+    session_puts(s, "   • Only one disk can be moved at a time\n");
+    session_puts(s, "   • A larger disk cannot be placed on a smaller disk\n");
     
-    // Generate random numbers from different ranges
-    int numbers[6];
-    numbers[0] = (rand() % 9) + 1;        // 1-9
-    numbers[1] = (rand() % 9) + 1;        // 1-9
-    numbers[2] = (rand() % 9) + 2;        // 2-10
-    numbers[3] = ((rand() % 4) + 1) * 5;  // 5, 10, 15, 20
-    numbers[4] = ((rand() % 4) + 2) * 10; // 20, 30, 40, 50
-    numbers[5] = ((rand() % 4) + 1) * 25; // 25, 50, 75, 100
+    display_hanoi_state(s, game->pegs, game->peg_count, game->disks);
     
-    // Generate random target
-    int target = (rand() % 800) + 100; // 100-899
+    session_printf(s, "\nMoves: %llu (minimum possible: %llu)\n",
+           (unsigned long long)game->moves, (unsigned long long)game->min_moves);
+    session_puts(s, "\nEnter moves (format: A B to move from tower A to B), several per line as AC AB CB\n");
+    session_puts(s, "Type 'hint' for the next move, 'skip' to skip");
+    if (s->fd < 0) session_puts(s, ", 'file PATH' to apply a list of moves");
+    session_puts(s, "\n\n");
+    session_printf(s, "%s\n", game->message);
     
-    printf("Available numbers: ");
-    for(int i = 0; i < 6; i++) {
-        printf("%d ", numbers[i]);
-    }
-    printf("\nTarget: %d\n\n", target);
+    session_puts(s, prompt);
+    render_commit(s);
+}
+
+void challenge_tour_hanoi_start(Session* s) {
+    clear_screen(s);
+    display_header(s, "CHALLENGE 5: Tour de Hanoi");
+    
+    session_printf(s, "🎯 Objective: Move all disks from the first tower to the last\n");
+    session_printf(s, "   Large towers take millions of moves: send them as a batch or a file\n");
+    session_printf(s, "   With 4 or more towers (Reve's puzzle) far fewer moves are needed\n\n");
+    session_printf(s, "Number of disks (1-%d), optionally followed by towers (3-%d); Enter for 3-5 disks on 3: ",
+           HANOI_MAX_DISKS, HANOI_MAX_PEGS);
+    s->screen = SCREEN_HANOI_SIZE;
+}
+
+void challenge_tour_hanoi_size_input(Session* s, const char* input) {
+    HanoiGame* game = &s->game.hanoi;
     
-    time_t start_time = time(NULL);
+    // Randomize number of disks (3-5) unless one was asked for
+    int disks = (rand() % 3) + 3, peg_count = 3;
+    if (input[0] && sscanf(input, "%d %d", &disks, &peg_count) < 1) disks = 0;
+    if (disks < 1 || disks > HANOI_MAX_DISKS || peg_count < 3 || peg_count > HANOI_MAX_PEGS) {
+        session_printf(s, "Number of disks (1-%d) and towers (3-%d): ", HANOI_MAX_DISKS, HANOI_MAX_PEGS);
+        return;
+    }
     
-    printf("Enter your solution (e.g., (25*5)+10-2)\n");
-    printf("Or type 'skip' to skip\n\n");
+    game->disks = disks;
+    game->peg_count = peg_count;
+    memset(game->pegs, 0, sizeof(game->pegs));
+    game->pegs[0] = disks == 64 ? ~0ull : (1ull << disks) - 1;
+    game->moves = 0;
+    game->min_moves = hanoi_min_moves[disks][peg_count]; // 2^n - 1 with three towers
+    game->on_track = 1;
+    game->streaming = 0;
+    game->message = "";
     
-    char solution[500];
-    printf("Your solution: ");
-    fgets(solution, sizeof(solution), stdin);
-    solution[strcspn(solution, "\n")] = 0;
+    challenge_begin(s);
+    s->screen = SCREEN_HANOI;
+    hanoi_render(s, "Move: ");
+}
+
+// Take the next part of a batch; long batches arrive in several parts,
+// before the end of the line
+void hanoi_stream(Session* s, const char* data, size_t len) {
+    HanoiGame* game = &s->game.hanoi;
+    if (!game->streaming) {
+        hanoi_reader_init(&game->reader);
+        game->streaming = 1;
+    }
+    hanoi_reader_feed(&game->reader, game, data, len);
+}
+
+// A batch is complete: check it against the optimal solution, then either
+// redraw or score the solved tower
+void hanoi_batch_done(Session* s) {
+    HanoiGame* game = &s->game.hanoi;
+    HanoiReader* reader = &game->reader;
+    game->streaming = 0;
+    hanoi_reader_finish(reader);
     
-    time_t end_time = time(NULL);
-    int time_taken = (int)difftime(end_time, start_time);
+    int on_track = hanoi_on_track(game);
+    if (!reader->valid) {
+        snprintf(game->feedback, sizeof(game->feedback), "❌ %s; %llu moves applied before it.",
+                 reader->error, (unsigned long long)reader->applied);
+    } else if (reader->applied > 1) {
+        snprintf(game->feedback, sizeof(game->feedback), "✅ %llu moves applied; %s.",
+                 (unsigned long long)reader->applied,
+                 on_track ? "still on the optimal solution" : "off the optimal solution");
+    } else if (!on_track) {
+        snprintf(game->feedback, sizeof(game->feedback), "⚠️  Off the optimal solution.");
+    } else {
+        game->feedback[0] = '\0';
+    }
+    game->message = game->feedback;
     
-    if (strcmp(solution, "skip") == 0) {
-        printf("\n❌ Challenge skipped!\n");
-        pause_screen();
+    uint64_t all = game->disks == 64 ? ~0ull : (1ull << game->disks) - 1;
+    if (game->pegs[game->peg_count - 1] != all) {
+        hanoi_render(s, "Move: ");
         return;
     }
     
-    // Validate solution
-    int valid = 0;
-    int result = evaluate_expression(solution, numbers, 6, &valid);
+    // Win condition: show the solved towers, then scroll the results below
+    hanoi_render(s, "");
+    session_printf(s, "✅ Congratulations! You solved the Tower of Hanoi!\n");
     
-    // Additional simple check: look for target in solution
-    char target_str[20];
-    sprintf(target_str, "%d", target);
-    int contains_target = (strstr(solution, target_str) != NULL);
+    // Score based on number of moves
+    uint64_t extra = game->moves - game->min_moves;
+    int score = extra < (POINTS_HANOI - HANOI_MIN_SCORE) / 2 ? POINTS_HANOI - (int)extra * 2 : HANOI_MIN_SCORE;
     
-    if (contains_target && valid) {
-        // Calculate score based on time
-        int base_score = POINTS_COMPTE_BON;
-        int time_penalty = (time_taken / 30) * 2; // -2 points per 30 seconds
-        int score = base_score - time_penalty;
-        if (score < 5) score = 5; // Minimum score
-        
-        printf("\n✅ Correct! Your solution works!\n");
-        printf("⏱️  Time taken: %d seconds\n", time_taken);
-        printf("🎯 Score earned: %d points\n", score);
-        
-        if (current_player.compte_bon_score == 0) {
-            current_player.challenges_completed++;
+    session_printf(s, "🎯 Moves used: %llu (optimal: %llu)\n",
+           (unsigned long long)game->moves, (unsigned long long)game->min_moves);
+    session_printf(s, "🎯 Score earned: %d points\n", score);
+    
+    challenge_record_attempt(s, CHALLENGE_HANOI, score, game->moves);
+    
+    pause_screen(s);
+}
+
+void challenge_tour_hanoi_input(Session* s, const char* input) {
+    HanoiGame* game = &s->game.hanoi;
+    
+    // The end of a batch that was already streaming
+    if (game->streaming) {
+        hanoi_stream(s, input, strlen(input));
+        hanoi_batch_done(s);
+        return;
+    }
+    
+    if (strcmp(input, "skip") == 0) {
+        session_printf(s, "\n❌ Challenge skipped!\n");
+        challenge_record_attempt(s, CHALLENGE_HANOI, 0, game->moves);
+        pause_screen(s);
+        return;
+    }
+    
+    // The reference solution's next move, while the player still follows it
+    if (strcmp(input, "hint") == 0) {
+        int from, to;
+        if (!hanoi_on_track(game) || game->moves >= game->min_moves) {
+            game->message = "💡 No hint: the towers are off the reference solution.";
+        } else {
+            hanoi_reference_move(game->disks, game->peg_count, game->moves, &from, &to);
+            snprintf(game->feedback, sizeof(game->feedback), "💡 Next move: %c %c", 'A' + from, 'A' + to);
+            game->message = game->feedback;
         }
-        
-        if (score > current_player.compte_bon_score) {
-            current_player.total_score = current_player.total_score - current_player.compte_bon_score + score;
-            current_player.compte_bon_score = score;
-            save_player_scores(&current_player);
-            printf("🏆 New personal best!\n");
+        hanoi_render(s, "Move: ");
+        return;
+    }
+    
+    // A list of moves from a local file, for the terminal player only
+    if (strncmp(input, "file ", 5) == 0 && s->fd < 0) {
+        hanoi_reader_init(&game->reader);
+        if (!hanoi_reader_feed_file(&game->reader, game, input + 5)) {
+            game->message = "❌ Could not read that file.";
+            hanoi_render(s, "Move: ");
+            return;
         }
-    } else {
-        printf("\n❌ Invalid solution! Make sure you:\n");
-        printf("   • Use only the given numbers (each once)\n");
-        printf("   • Reach the exact target: %d\n", target);
+        hanoi_batch_done(s);
+        return;
     }
     
-    pause_screen();
+    hanoi_stream(s, input, strlen(input));
+    hanoi_batch_done(s);
 }
 
 /*
 ================================================================================
-    CHALLENGE 2: MASTERMIND ALGORITHMIQUE
-    Guess the secret sequence with feedback on correct/misplaced digits
+    CHALLENGE REGISTRY
+    Every challenge the menu, scores and statistics know about. A new one
+    adds an entry here and a ChallengeId; its scores take the next free
+    slot of the store record.
+================================================================================
+*/
+
+_Static_assert(CHALLENGE_COUNT <= STORE_SCORE_SLOTS, "every challenge needs a score slot");
+
+const ChallengeInfo CHALLENGES[CHALLENGE_COUNT] = {
+    [CHALLENGE_COMPTE_BON] = { "Le Compte est Bon",        "Compte",     "🎯", 3, POINTS_COMPTE_BON, challenge_compte_bon_start },
+    [CHALLENGE_MASTERMIND] = { "Mastermind Algorithmique", "Mastermind", "🧩", 3, POINTS_MASTERMIND, challenge_mastermind_start },
+    [CHALLENGE_ROBOT]      = { "Course de Robots",         "Robots",     "🤖", 5, POINTS_ROBOT,      challenge_course_robots_start },
+    [CHALLENGE_TRI]        = { "Tri Ultime",               "Tri",        "📊", 2, POINTS_TRI,        challenge_tri_ultime_start },
+    [CHALLENGE_HANOI]      = { "Tour de Hanoi",            "Hanoi",      "🗼", 4, POINTS_HANOI,      challenge_tour_hanoi_start }
+};
+
+/*
+================================================================================
+    LEADERBOARD AND STATISTICS
 ================================================================================
 */
 
-void challenge_mastermind() {
-    clear_screen();
-    display_header("CHALLENGE 2: Mastermind Algorithmique");
+// Name of the window a challenge board covers
+const char* window_label(int days) {
+    if (days == 1) return "today";
+    if (days == WINDOW_WEEK_DAYS) return "this week";
+    return "this season";
+}
+
+// Best results of one challenge over the last few days, merged from the
+// day buckets
+void display_window_leaderboard(Session* s, ChallengeId challenge, int days) {
+    const ChallengeInfo* info = &CHALLENGES[challenge];
+    char title[128];
+    snprintf(title, sizeof(title), "%s %s - %s", info->icon, info->name, window_label(days));
     
-    printf("🎯 Objective: Guess the secret 4-digit sequence (digits 1-6)\n");
-    printf("   After each guess, you'll get feedback for each position:\n");
-    printf("   • ✓ = Correct digit in correct position\n");
-    printf("   • ? = Correct digit in wrong position\n");
-    printf("   • x = Wrong digit\n\n");
+    render_begin(s);
+    display_header(s, title);
     
-    // Generate secret sequence
-    int secret[4];
-    for(int i = 0; i < 4; i++) {
-        secret[i] = (rand() % 6) + 1;
+    WindowEntry top[LEADERBOARD_PAGE_SIZE];
+    uint32_t attempts;
+    int shown = window_top(&window_boards, challenge, days, time(NULL), top, LEADERBOARD_PAGE_SIZE, &attempts);
+    
+    session_printf(s, "╔═════════╦══════════════════════════╦══════════════╦════════════════════╗\n");
+    session_printf(s, "║ #       ║ Player Name              ║ Best Score   ║ Max Points         ║\n");
+    session_printf(s, "╠═════════╬══════════════════════════╬══════════════╬════════════════════╣\n");
+    for(int i = 0; i < LEADERBOARD_PAGE_SIZE; i++) {
+        if (i < shown) {
+            const LeaderNode* node = top[i].slot < leaderboard.by_slot_capacity ? leaderboard.by_slot[top[i].slot] : NULL;
+            session_printf(s, "║ %-7d ║ %-24s ║ %-12d ║ %-18d ║\n",
+                   i + 1, node ? node->name : "?", top[i].score, info->max_points);
+        } else {
+            session_puts(s, "║         ║                          ║              ║                    ║\n");
+        }
     }
+    session_printf(s, "╚═════════╩══════════════════════════╩══════════════╩════════════════════╝\n");
     
-    int attempts = 0;
-    int max_attempts = 10;
-    int won = 0;
+    char count[32];
+    session_printf(s, "\n📍 %s attempt%s completed %s\n", format_count(count, attempts),
+           attempts == 1 ? "" : "s", window_label(days));
     
-    while(attempts < max_attempts && !won) {
-        printf("\nAttempt %d/%d\n", attempts + 1, max_attempts);
-        printf("Enter 4 digits (1-6): ");
-        
-        int guess[4];
-        char input[10];
-        fgets(input, sizeof(input), stdin);
-        
-        if (sscanf(input, "%d %d %d %d", &guess[0], &guess[1], &guess[2], &guess[3]) != 4) {
-            printf("❌ Invalid input! Please enter 4 numbers separated by spaces.\n");
-            continue;
-        }
-        
-        attempts++;
-        
-        // Generate feedback for each position
-        char feedback[4];
-        int secret_used[4] = {0};
-        int guess_used[4] = {0};
-        
-        // First pass: mark exact matches
-        for(int i = 0; i < 4; i++) {
-            if (guess[i] == secret[i]) {
-                feedback[i] = 'v'; // correct position
-                secret_used[i] = 1;
-                guess_used[i] = 1;
-            } else {
-                feedback[i] = 'x'; // default to wrong
-            }
-        }
-        
-        // Second pass: find correct digits in wrong positions
-        for(int i = 0; i < 4; i++) {
-            if (!guess_used[i]) {
-                for(int j = 0; j < 4; j++) {
-                    if (!secret_used[j] && guess[i] == secret[j]) {
-                        feedback[i] = '?'; // correct digit, wrong position
-                        secret_used[j] = 1;
-                        break;
-                    }
-                }
-            }
-        }
-        
-        // Display feedback per position
-        printf("Feedback: ");
-        for(int i = 0; i < 4; i++) {
-            if (feedback[i] == 'v') printf("✓ ");
-            else if (feedback[i] == '?') printf("? ");
-            else printf("x ");
-        }
-        printf("\n");
-        
-        // Check win condition
-        won = 1;
-        for(int i = 0; i < 4; i++) {
-            if (feedback[i] != 'v') {
-                won = 0;
-                break;
-            }
-        }
+    session_puts(s, "\n'day', 'week', 'season' or 'ever' to change the window,\n");
+    session_printf(s, "'c 1'-'c %d' for another challenge, 'all' for the global board,\n", CHALLENGE_COUNT);
+    session_puts(s, "or Enter to return: ");
+    render_commit(s);
+    s->screen = SCREEN_LEADERBOARD;
+}
+
+// Top scores of one challenge, read from its score column
+void display_challenge_leaderboard(Session* s, ChallengeId challenge) {
+    if (s->game.leaderboard.window > 0) {
+        display_window_leaderboard(s, challenge, s->game.leaderboard.window);
+        return;
     }
     
-    if (won) {
-        // Score based on number of attempts (fewer is better)
-        int score = POINTS_MASTERMIND - (attempts - 1) * 2;
-        if (score < 5) score = 5;
-        
-        printf("\n✅ Congratulations! You cracked the code!\n");
-        printf("🎯 Attempts: %d\n", attempts);
-        printf("🎯 Score earned: %d points\n", score);
-        
-        if (current_player.mastermind_score == 0) {
-            current_player.challenges_completed++;
-        }
-        
-        if (score > current_player.mastermind_score) {
-            current_player.total_score = current_player.total_score - current_player.mastermind_score + score;
-            current_player.mastermind_score = score;
-            save_player_scores(&current_player);
-            printf("🏆 New personal best!\n");
+    const ChallengeInfo* info = &CHALLENGES[challenge];
+    const int32_t* column = score_columns.columns[challenge];
+    char title[96];
+    snprintf(title, sizeof(title), "%s %s LEADERBOARD", info->icon, info->name);
+    
+    render_begin(s);
+    display_header(s, title);
+    
+    long long sum;
+    int best;
+    int players = score_column_summary(&score_columns, challenge, &sum, &best);
+    int slots[LEADERBOARD_PAGE_SIZE];
+    int shown = score_column_top(&score_columns, challenge, slots, LEADERBOARD_PAGE_SIZE);
+    
+    session_printf(s, "╔═════════╦══════════════════════════╦══════════════╦════════════════════╗\n");
+    session_printf(s, "║ #       ║ Player Name              ║ Score        ║ Max Points         ║\n");
+    session_printf(s, "╠═════════╬══════════════════════════╬══════════════╬════════════════════╣\n");
+    for(int i = 0; i < LEADERBOARD_PAGE_SIZE; i++) {
+        if (i < shown) {
+            const LeaderNode* node = slots[i] < leaderboard.by_slot_capacity ? leaderboard.by_slot[slots[i]] : NULL;
+            session_printf(s, "║ %-7d ║ %-24s ║ %-12d ║ %-18d ║\n",
+                   i + 1, node ? node->name : "?", column[slots[i]], info->max_points);
+        } else {
+            session_puts(s, "║         ║                          ║              ║                    ║\n");
         }
+    }
+    session_printf(s, "╚═════════╩══════════════════════════╩══════════════╩════════════════════╝\n");
+    
+    if (players > 0) {
+        session_printf(s, "\n📍 %d player%s scored, average %.1f, best %d\n", players,
+               players == 1 ? " has" : "s have", (double)sum / players, best);
+    } else {
+        session_puts(s, "\n📍 Nobody has scored yet\n");
+    }
+    
+    session_puts(s, "\n'day', 'week' or 'season' for recent results only,\n");
+    session_printf(s, "'c 1'-'c %d' for another challenge, 'all' for the global board,\n", CHALLENGE_COUNT);
+    session_puts(s, "or Enter to return: ");
+    render_commit(s);
+    s->screen = SCREEN_LEADERBOARD;
+}
+
+// Render the current page of the global leaderboard
+void display_global_leaderboard(Session* s) {
+    int page = s->game.leaderboard.page;
+    render_begin(s);
+    display_header(s, "🏆 GLOBAL LEADERBOARD 🏆");
+    
+    if (leaderboard.count == 0) {
+        session_puts(s, "No scores recorded yet!\n");
+        render_commit(s);
+        pause_screen(s);
+        return;
+    }
+    
+    int pages = (leaderboard.count + LEADERBOARD_PAGE_SIZE - 1) / LEADERBOARD_PAGE_SIZE;
+    if (page >= pages) page = pages - 1;
+    if (page < 0) page = 0;
+    s->game.leaderboard.page = page;
+    
+    session_printf(s, "╔═════════╦══════════════════════════╦══════════════╦════════════════════╗\n");
+    session_printf(s, "║ #       ║ Player Name              ║ Total Score  ║ Challenges Done    ║\n");
+    session_printf(s, "╠═════════╬══════════════════════════╬══════════════╬════════════════════╣\n");
+    
+    // Seek to the first row of the page in O(log n), then walk the bottom level.
+    // Rows are ordered with ties broken by time, but numbered like the rank
+    // on the login and stats screens: tied players share a number
+    int row = page * LEADERBOARD_PAGE_SIZE + 1;
+    LeaderNode* node = leaderboard_at(&leaderboard, row);
+    for(int i = 0; node && i < LEADERBOARD_PAGE_SIZE; i++, row++) {
+        session_printf(s, "║ %-7d ║ %-24s ║ %-12d ║ %-18d ║\n",
+               histogram_rank(&total_histogram, node->total_score), node->name,
+               node->total_score, node->challenges_completed);
+        node = node->links[0].next;
+    }
+    // Pad short pages so the rows below stay put while paging
+    for(; row <= (page + 1) * LEADERBOARD_PAGE_SIZE; row++) {
+        session_puts(s, "║         ║                          ║              ║                    ║\n");
+    }
+    
+    session_printf(s, "╚═════════╩══════════════════════════╩══════════════╩════════════════════╝\n");
+    
+    if (leaderboard_rank(&leaderboard, store_find(&score_store, s->player.name)) > 0) {
+        session_printf(s, "\n📍 Your rank: #%d of %d (tied players share a rank)\n",
+               histogram_rank(&total_histogram, s->player.total_score), leaderboard.count);
     } else {
-        printf("\n❌ Out of attempts! The secret was: ");
-        for(int i = 0; i < 4; i++) printf("%d ", secret[i]);
-        printf("\n");
+        session_puts(s, "\n\n");
+    }
+    
+    session_printf(s, "\nPage %d/%d - 'n' next, 'p' previous, a page number to jump,\n", page + 1, pages);
+    session_printf(s, "'me' for your page, 'c 1'-'c %d' for one challenge ('week' for this week's),\n", CHALLENGE_COUNT);
+    session_puts(s, "or Enter to return: ");
+    render_commit(s);
+    s->screen = SCREEN_LEADERBOARD;
+}
+
+// Render whichever board the session is looking at
+void display_leaderboard(Session* s) {
+    TRACE_BEGIN(started);
+    rankings_load();
+    int challenge = s->game.leaderboard.challenge;
+    if (challenge >= 0) display_challenge_leaderboard(s, challenge);
+    else display_global_leaderboard(s);
+    METRIC_ADD(METRIC_LEADERBOARD_VIEWS, 1);
+    TRACE_END(TRACE_LEADERBOARD, started, challenge);
+}
+
+void leaderboard_start(Session* s) {
+    s->game.leaderboard.page = 0;
+    s->game.leaderboard.challenge = -1;
+    s->game.leaderboard.window = 0;
+    display_leaderboard(s);
+}
+
+void show_main_menu(Session* s);
+
+void leaderboard_input(Session* s, const char* input) {
+    int* page = &s->game.leaderboard.page;
+    int challenge;
+    rankings_load();
+    
+    if (input[0] == '\0') {
+        show_main_menu(s);
+        return;
+    }
+    
+    if (sscanf(input, "c %d", &challenge) == 1 && challenge >= 1 && challenge <= CHALLENGE_COUNT) {
+        s->game.leaderboard.challenge = challenge - 1;
+        display_leaderboard(s);
+        return;
+    }
+    if (strcmp(input, "all") == 0) {
+        s->game.leaderboard.challenge = -1;
+        display_leaderboard(s);
+        return;
+    }
+    
+    // Windows apply to challenge boards; from the global one they open the first
+    int window = strcmp(input, "day") == 0 ? 1 :
+                 strcmp(input, "week") == 0 ? WINDOW_WEEK_DAYS :
+                 strcmp(input, "season") == 0 ? WINDOW_DAYS :
+                 strcmp(input, "ever") == 0 ? 0 : -1;
+    if (window >= 0) {
+        s->game.leaderboard.window = window;
+        if (s->game.leaderboard.challenge < 0) s->game.leaderboard.challenge = 0;
+        display_leaderboard(s);
+        return;
     }
     
-    pause_screen();
+    int my_rank = leaderboard_rank(&leaderboard, store_find(&score_store, s->player.name));
+    if (strcmp(input, "n") == 0) (*page)++;
+    else if (strcmp(input, "p") == 0) (*page)--;
+    else if (strcmp(input, "me") == 0 && my_rank > 0) *page = (my_rank - 1) / LEADERBOARD_PAGE_SIZE;
+    else if (atoi(input) > 0) *page = atoi(input) - 1;
+    
+    display_leaderboard(s);
+}
+
+void display_player_stats(Session* s) {
+    clear_screen(s);
+    display_header(s, "📊 YOUR STATISTICS 📊");
+    
+    session_printf(s, "Player: %s\n\n", s->player.name);
+    
+    char pct[16];
+    session_printf(s, "╔══════════════════════════════════╦═══════════╦════════════╦════════════╗\n");
+    session_printf(s, "║ Challenge                        ║ Score     ║ Max Points ║ Percentile ║\n");
+    session_printf(s, "╠══════════════════════════════════╬═══════════╬════════════╬════════════╣\n");
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        sprintf(pct, "%.1f%%", histogram_percentile(&challenge_histograms[i], s->player.scores[i]));
+        session_printf(s, "║ %d. %-29s ║ %-9d ║ %-10d ║ %-10s ║\n",
+               i + 1, CHALLENGES[i].name, s->player.scores[i], CHALLENGES[i].max_points, pct);
+    }
+    sprintf(pct, "%.1f%%", histogram_percentile(&total_histogram, s->player.total_score));
+    session_printf(s, "╠══════════════════════════════════╬═══════════╬════════════╬════════════╣\n");
+    session_printf(s, "║ TOTAL                            ║ %-9d ║ %-10d ║ %-10s ║\n", s->player.total_score, challenge_total_points(), pct);
+    session_printf(s, "╚══════════════════════════════════╩═══════════╩════════════╩════════════╝\n");
+    
+    if (total_histogram.count > 0) {
+        char rank[32], count[32];
+        session_printf(s, "\n🌍 Global Rank: #%s of %s\n",
+               format_count(rank, histogram_rank(&total_histogram, s->player.total_score)),
+               format_count(count, total_histogram.count));
+    }
+    session_printf(s, "📈 Challenges Completed: %d/%d\n", s->player.challenges_completed, CHALLENGE_COUNT);
+    
+    float completion = (s->player.challenges_completed / (float)CHALLENGE_COUNT) * 100;
+    session_printf(s, "📊 Completion Rate: %.1f%%\n", completion);
+    
+    // Everyone's solve times, and the pause before each line typed
+    char p50[16], p90[16], p99[16], think[16];
+    session_printf(s, "\n⏱️  Solve times, all players:\n");
+    session_printf(s, "╔════════════╦══════════╦══════════╦══════════╦══════════╦════════════╗\n");
+    session_printf(s, "║ Challenge  ║ Solves   ║ p50      ║ p90      ║ p99      ║ Think p50  ║\n");
+    session_printf(s, "╠════════════╬══════════╬══════════╬══════════╬══════════╬════════════╣\n");
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        const LogHistogram* solve = &timing_totals.solve[i];
+        const LogHistogram* pause = &timing_totals.think[i];
+        if (solve->count > 0) {
+            format_duration(p50, sizeof(p50), log_histogram_quantile(solve, 0.50));
+            format_duration(p90, sizeof(p90), log_histogram_quantile(solve, 0.90));
+            format_duration(p99, sizeof(p99), log_histogram_quantile(solve, 0.99));
+        } else {
+            strcpy(p50, "-");
+            strcpy(p90, "-");
+            strcpy(p99, "-");
+        }
+        if (pause->count > 0) format_duration(think, sizeof(think), log_histogram_quantile(pause, 0.50));
+        else strcpy(think, "-");
+        session_printf(s, "║ %-10s ║ %-8llu ║ %-8s ║ %-8s ║ %-8s ║ %-10s ║\n", CHALLENGES[i].short_name,
+               (unsigned long long)solve->count, p50, p90, p99, think);
+    }
+    session_printf(s, "╚════════════╩══════════╩══════════╩══════════╩══════════╩════════════╝\n");
+    
+    pause_screen(s);
 }
 
 /*
 ================================================================================
-    CHALLENGE 3: COURSE DE ROBOTS
-    Find the shortest path through a maze
+    MAIN MENU
+================================================================================
+*/
+
+void display_main_menu(Session* s) {
+    clear_screen(s);
+    display_banner(s);
+    
+    session_puts(s,
+        "  ╔═══════════════════════════════════════════════════════════════════════════╗\n"
+        "  ║                         🎮 MAIN MENU 🎮                                   ║\n"
+        "  ╠═══════════════════════════════════════════════════════════════════════════╣\n"
+        "  ║                                                                           ║\n");
+    
+    // One line per registered challenge; icons and stars are two columns wide
+    for(int i = 0; i < CHALLENGE_COUNT; i++) {
+        const ChallengeInfo* info = &CHALLENGES[i];
+        char points[16];
+        int width = 40 + 13 + 2 * info->difficulty + snprintf(points, sizeof(points), " - %dpts)", info->max_points);
+        session_printf(s, "  ║   %d. %s %-30s (Difficulty: ", i + 1, info->icon, info->name);
+        session_repeat(s, "⭐", info->difficulty);
+        session_printf(s, "%s%*s║\n", points, width < 75 ? 75 - width : 0, "");
+    }
+    
+    session_printf(s,
+        "  ║                                                                           ║\n"
+        "  ║   %d. 🏆 View Leaderboard                                                  ║\n"
+        "  ║   %d. 📊 View Your Statistics                                              ║\n"
+        "  ║   %d. 🚪 Exit                                                              ║\n"
+        "  ║                                                                           ║\n"
+        "  ╚═══════════════════════════════════════════════════════════════════════════╝\n\n",
+        MENU_LEADERBOARD, MENU_STATS, MENU_EXIT);
+    
+    session_printf(s, "  Player: %s | Total Score: %d | Completed: %d/%d\n\n",
+           s->player.name, s->player.total_score, s->player.challenges_completed, CHALLENGE_COUNT);
+    
+    // Saves the log writer could not commit since this player last looked
+    uint64_t failed = __atomic_load_n(&score_wal.failed, __ATOMIC_RELAXED);
+    if (failed > s->wal_failed_seen) {
+        uint64_t count = failed - s->wal_failed_seen;
+        session_printf(s, "  ⚠️  %llu score update%s could not be written to %s and went straight to the store.\n\n",
+               (unsigned long long)count, count == 1 ? "" : "s", SCORES_WAL_FILE);
+        s->wal_failed_seen = failed;
+    }
+}
+
+
+// Show the main menu and wait for a choice
+void show_main_menu(Session* s) {
+    display_main_menu(s);
+    session_printf(s, "  Select option (1-%d): ", MENU_EXIT);
+    s->screen = SCREEN_MENU;
+}
+
+void main_menu_input(Session* s, const char* input) {
+    int choice = 0;
+    sscanf(input, "%d", &choice);
+    
+    if (choice >= 1 && choice <= CHALLENGE_COUNT) {
+        CHALLENGES[choice - 1].start(s);
+        return;
+    }
+    
+    switch(choice) {
+        case MENU_LEADERBOARD:
+            leaderboard_start(s);
+            break;
+        case MENU_STATS:
+            display_player_stats(s);
+            break;
+        case MENU_EXIT:
+            session_printf(s, "\n  Thanks for playing, %s! Keep coding! 🚀\n\n", s->player.name);
+            s->screen = SCREEN_CLOSED;
+            break;
+        default:
+            session_printf(s, "\n  ❌ Invalid option! Please choose 1-%d.\n", MENU_EXIT);
+            pause_screen(s);
+    }
+}
+
+/*
+================================================================================
+    SESSIONS
+    Line-driven state machine shared by the terminal and the server
 ================================================================================
 */
 
-void display_maze(char maze[MAZE_SIZE][MAZE_SIZE]) {
-    printf("\n  ");
-    for(int i = 0; i < MAZE_SIZE; i++) printf("%d ", i);
-    printf("\n");
-    
-    for(int i = 0; i < MAZE_SIZE; i++) {
-        printf("%d ", i);
-        for(int j = 0; j < MAZE_SIZE; j++) {
-            printf("%c ", maze[i][j]);
-        }
-        printf("\n");
-    }
-}
-
-int is_valid_move(int x, int y, char maze[MAZE_SIZE][MAZE_SIZE], int visited[MAZE_SIZE][MAZE_SIZE]) {
-    return (x >= 0 && x < MAZE_SIZE && y >= 0 && y < MAZE_SIZE &&
-            maze[x][y] != WALL && !visited[x][y]);
-}
-
-void challenge_course_robots() {
-    clear_screen();
-    display_header("CHALLENGE 3: Course de Robots");
-    
-    printf("🎯 Objective: Find the shortest path from S to E\n");
-    printf("   Commands: N (North/Up), S (South/Down), E (East/Right), O (West/Left)\n\n");
-    
-    // Predefined mazes with unique solutions
-    char mazes[4][MAZE_SIZE][MAZE_SIZE] = {
-        // Maze 1 - Optimal: 18 steps
-        {
-            {START, '.', '.', '#', '.', '.', '.', '#', '.', '.'},
-            {'#', '#', '.', '#', '.', '#', '.', '#', '.', '#'},
-            {'.', '.', '.', '.', '.', '#', '.', '.', '.', '.'},
-            {'.', '#', '#', '#', '.', '#', '#', '#', '.', '#'},
-            {'.', '.', '.', '.', '.', '.', '.', '.', '.', '.'},
-            {'#', '#', '.', '#', '#', '#', '.', '#', '#', '.'},
-            {'.', '.', '.', '.', '.', '.', '.', '#', '.', '.'},
-            {'.', '#', '#', '#', '.', '#', '.', '#', '.', '#'},
-            {'.', '.', '.', '#', '.', '.', '.', '.', '.', END},
-            {'#', '#', '.', '#', '#', '#', '#', '#', '.', '#'}
-        },
-        // Maze 2 - Optimal: 20 steps
-        {
-            {START, '.', '#', '.', '.', '.', '#', '.', '.', '.'},
-            {'.', '.', '#', '.', '#', '.', '#', '.', '#', '.'},
-            {'#', '.', '.', '.', '#', '.', '.', '.', '#', '.'},
-            {'#', '#', '#', '.', '#', '#', '#', '.', '#', '.'},
-            {'.', '.', '.', '.', '.', '.', '.', '.', '.', '.'},
-            {'.', '#', '#', '#', '.', '#', '#', '#', '#', '#'},
-            {'.', '.', '.', '#', '.', '.', '.', '.', '.', '.'},
-            {'#', '#', '.', '#', '#', '#', '.', '#', '#', '.'},
-            {'.', '.', '.', '.', '.', '#', '.', '.', '.', END},
-            {'.', '#', '#', '#', '.', '#', '#', '#', '.', '#'}
-        },
-        // Maze 3 - Optimal: 22 steps
-        {
-            {START, '.', '.', '.', '#', '.', '.', '.', '.', '.'},
-            {'#', '#', '#', '.', '#', '.', '#', '#', '#', '.'},
-            {'.', '.', '.', '.', '.', '.', '.', '.', '#', '.'},
-            {'.', '#', '#', '#', '#', '#', '#', '.', '#', '.'},
-            {'.', '.', '.', '.', '.', '.', '.', '.', '#', '.'},
-            {'#', '#', '#', '.', '#', '#', '#', '.', '#', '.'},
-            {'.', '.', '#', '.', '.', '.', '#', '.', '.', '.'},
-            {'.', '.', '#', '#', '#', '.', '#', '#', '#', '#'},
-            {'.', '.', '.', '.', '#', '.', '.', '.', '.', END},
-            {'#', '#', '#', '.', '#', '#', '#', '#', '.', '#'}
-        },
-        // Maze 4 - Optimal: 24 steps
-        {
-            {START, '.', '#', '.', '.', '.', '.', '#', '.', '.'},
-            {'.', '.', '#', '#', '#', '#', '.', '#', '.', '#'},
-            {'.', '.', '.', '.', '.', '#', '.', '.', '.', '#'},
-            {'#', '#', '#', '#', '.', '#', '.', '#', '.', '#'},
-            {'.', '.', '.', '.', '.', '.', '.', '#', '.', '.'},
-            {'.', '#', '#', '#', '#', '#', '.', '#', '#', '.'},
-            {'.', '.', '.', '.', '.', '#', '.', '.', '.', '.'},
-            {'#', '#', '#', '.', '.', '#', '#', '#', '.', '#'},
-            {'.', '.', '#', '.', '.', '.', '.', '#', '.', END},
-            {'.', '.', '#', '#', '#', '#', '.', '#', '.', '#'}
+Session* session_create(int fd) {
+    Session* s = calloc(1, sizeof(Session));
+    if (!s) return NULL;
+    s->fd = fd;
+    s->sink = &s->out;
+    s->wal_failed_seen = __atomic_load_n(&score_wal.failed, __ATOMIC_RELAXED);
+    METRIC_ADD(METRIC_SESSIONS, 1);
+    return s;
+}
+
+void session_free(Session* s) {
+    if (s->screen == SCREEN_MASTERMIND) {
+        mastermind_engine_free(&s->game.mastermind.engine);
+        mastermind_engine_free(&s->game.mastermind.solver);
+    }
+    if (s->screen == SCREEN_ROBOT) maze_free(&s->game.robot.maze);
+    if (s->screen == SCREEN_TRI) tri_free(&s->game.tri);
+    free(s->out.data);
+    free(s->frame.data);
+    free(s->shown.data);
+    free(s);
+}
+
+// Challenge being played on a screen, or -1 outside one
+int screen_challenge(Screen screen) {
+    switch(screen) {
+        case SCREEN_COMPTE_BON:  return CHALLENGE_COMPTE_BON;
+        case SCREEN_MASTERMIND:  return CHALLENGE_MASTERMIND;
+        case SCREEN_ROBOT:       return CHALLENGE_ROBOT;
+        case SCREEN_TRI:         return CHALLENGE_TRI;
+        case SCREEN_HANOI:       return CHALLENGE_HANOI;
+        default:                 return -1;
+    }
+}
+
+// Resume whichever screen is waiting on this line; lines typed during a
+// challenge are timed against the previous one
+void session_handle_line(Session* s, const char* line) {
+    TRACE_BEGIN(started);
+    Screen screen = s->screen;
+    int challenge = screen_challenge(screen);
+    if (challenge >= 0) {
+        int64_t now = clock_now_ns();
+        timing_record(&timing_totals.think[challenge], &timing_recent.think[challenge], now - s->last_input);
+        s->last_input = now;
+    }
+    
+    switch(s->screen) {
+        case SCREEN_LOGIN:       login_input(s, line); break;
+        case SCREEN_MENU:        main_menu_input(s, line); break;
+        case SCREEN_PAUSE:       show_main_menu(s); break;
+        case SCREEN_LEADERBOARD: leaderboard_input(s, line); break;
+        case SCREEN_COMPTE_BON_LEVEL: challenge_compte_bon_level_input(s, line); break;
+        case SCREEN_COMPTE_BON:  challenge_compte_bon_input(s, line); break;
+        case SCREEN_MASTERMIND_VARIANT: challenge_mastermind_variant_input(s, line); break;
+        case SCREEN_MASTERMIND:  challenge_mastermind_input(s, line); break;
+        case SCREEN_ROBOT_SIZE:  challenge_course_robots_size_input(s, line); break;
+        case SCREEN_ROBOT:       challenge_course_robots_input(s, line); break;
+        case SCREEN_TRI_SETUP:   challenge_tri_ultime_setup_input(s, line); break;
+        case SCREEN_TRI:         challenge_tri_ultime_input(s, line); break;
+        case SCREEN_HANOI_SIZE:  challenge_tour_hanoi_size_input(s, line); break;
+        case SCREEN_HANOI:       challenge_tour_hanoi_input(s, line); break;
+        case SCREEN_CLOSED:      break;
+    }
+    METRIC_ADD(METRIC_INPUT_LINES, 1);
+    TRACE_END(TRACE_INPUT, started, screen);
+}
+
+// Split raw input into lines; characters past SESSION_LINE_MAX are dropped
+void session_feed(Session* s, const char* data, size_t len) {
+    for(size_t i = 0; i < len && s->screen != SCREEN_CLOSED; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            if (s->line_len > 0 && s->line[s->line_len - 1] == '\r') s->line_len--;
+            s->line[s->line_len] = '\0';
+            s->line_len = 0;
+            session_handle_line(s, s->line);
+        } else if (s->line_len < SESSION_LINE_MAX - 1) {
+            s->line[s->line_len++] = c;
+        } else if (s->screen == SCREEN_ROBOT) {
+            // Robot paths can be far longer than a line: pass each full
+            // buffer on instead of dropping the rest
+            robot_stream(s, s->line, s->line_len);
+            s->line_len = 0;
+            s->line[s->line_len++] = c;
+        } else if (s->screen == SCREEN_TRI) {
+            // Same for long batches of Tri Ultime operations
+            tri_stream(s, s->line, s->line_len);
+            s->line_len = 0;
+            s->line[s->line_len++] = c;
+        } else if (s->screen == SCREEN_HANOI) {
+            // and of Hanoi moves
+            hanoi_stream(s, s->line, s->line_len);
+            s->line_len = 0;
+            s->line[s->line_len++] = c;
         }
-    };
+    }
+}
+
+/*
+================================================================================
+    SERVER MODE
+    Many sessions over TCP or a Unix socket, one epoll-driven thread
+================================================================================
+*/
+
+#ifdef __linux__
+
+volatile sig_atomic_t server_stop = 0;
+
+void server_handle_signal(int sig) {
+    (void)sig;
+    server_stop = 1;
+}
+
+// Listen on "PORT" (TCP, all interfaces) or "unix:PATH"
+int server_listen(const char* address) {
+    int fd;
+    
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", address + 5);
+        unlink(addr.sun_path);
+        
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0) return -1;
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons((uint16_t)atoi(address));
+        
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0) return -1;
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(fd);
+            return -1;
+        }
+    }
     
-    int optimal_paths[4] = {18, 20, 22, 24};
+    if (listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Arm EPOLLOUT only while output is pending
+void server_watch(int epfd, Session* s) {
+    int want_write = s->out.len > 0;
+    if (want_write == s->want_write) return;
     
-    // Randomly select a maze
-    int maze_idx = rand() % 4;
-    char maze[MAZE_SIZE][MAZE_SIZE];
-    for(int i = 0; i < MAZE_SIZE; i++) {
-        for(int j = 0; j < MAZE_SIZE; j++) {
-            maze[i][j] = mazes[maze_idx][i][j];
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0);
+    ev.data.ptr = s;
+    epoll_ctl(epfd, EPOLL_CTL_MOD, s->fd, &ev);
+    s->want_write = want_write;
+}
+
+void server_drop(int epfd, Session** sessions, Session* s) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    if (s->prev) s->prev->next = s->next;
+    else *sessions = s->next;
+    if (s->next) s->next->prev = s->prev;
+    session_free(s);
+}
+
+void server_accept(int epfd, int listen_fd, Session** sessions) {
+    for(;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK);
+        if (fd < 0) return;
+        
+        Session* s = session_create(fd);
+        if (!s) {
+            close(fd);
+            continue;
+        }
+        
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = s;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            session_free(s);
+            continue;
+        }
+        
+        s->next = *sessions;
+        if (*sessions) (*sessions)->prev = s;
+        *sessions = s;
+        
+        login_start(s);
+        session_flush(s);
+        server_watch(epfd, s);
+    }
+}
+
+// Read whatever the client sent and run it through the state machine;
+// returns 0 once the session should be closed
+int server_read(Session* s) {
+    char buf[4096];
+    for(;;) {
+        ssize_t n = read(s->fd, buf, sizeof(buf));
+        if (n > 0) {
+            session_feed(s, buf, n);
+            continue;
         }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 1;
+        return 0;
+    }
+}
+
+int run_server(const char* address) {
+    int listen_fd = server_listen(address);
+    if (listen_fd < 0) {
+        printf("❌ Could not listen on %s: %s\n", address, strerror(errno));
+        return 1;
     }
-    int optimal_path = optimal_paths[maze_idx];
     
-    display_maze(maze);
+    int epfd = epoll_create1(0);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL; // The listener is the only event without a session
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
     
-    printf("\nEnter your path (e.g., SSEEENNNEE) or 'skip': ");
-    char path[MAX_PATH_LENGTH];
-    fgets(path, sizeof(path), stdin);
-    path[strcspn(path, "\n")] = 0;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, server_handle_signal);
+    signal(SIGTERM, server_handle_signal);
     
-    if (strcmp(path, "skip") == 0) {
-        printf("\n❌ Challenge skipped!\n");
-        pause_screen();
-        return;
-    }
+    printf("🎮 Challenge Arena server listening on %s (Ctrl+C to stop)\n", address);
+    fflush(stdout);
     
-    // Simulate the path
-    int x = 0, y = 0; // Start position
-    int valid = 1;
-    int steps = strlen(path);
+    Session* sessions = NULL;
+    struct epoll_event events[SERVER_MAX_EVENTS];
     
-    for(int i = 0; i < steps && valid; i++) {
-        char move = toupper(path[i]);
-        int new_x = x, new_y = y;
-        
-        switch(move) {
-            case 'N': new_x--; break;
-            case 'S': new_x++; break;
-            case 'E': new_y++; break;
-            case 'O': new_y--; break;
-            default: valid = 0; break;
+    while (!server_stop) {
+        int n = epoll_wait(epfd, events, SERVER_MAX_EVENTS, -1);
+        metrics_poll();
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
         }
         
-        if (new_x < 0 || new_x >= MAZE_SIZE || new_y < 0 || new_y >= MAZE_SIZE ||
-            maze[new_x][new_y] == WALL) {
-            valid = 0;
-        } else {
-            x = new_x;
-            y = new_y;
-            if (maze[x][y] != START && maze[x][y] != END) {
-                maze[x][y] = PATH;
+        for(int i = 0; i < n; i++) {
+            Session* s = events[i].data.ptr;
+            if (!s) {
+                server_accept(epfd, listen_fd, &sessions);
+                continue;
+            }
+            
+            int alive = 1;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                alive = server_read(s);
+            }
+            if (!session_flush(s)) alive = 0;
+            
+            // A finished session stays open until its goodbye is written
+            if (!alive || (s->screen == SCREEN_CLOSED && s->out.len == 0)) {
+                server_drop(epfd, &sessions, s);
+            } else {
+                server_watch(epfd, s);
             }
         }
     }
     
-    if (valid && x == 9 && y == 9) {
-        printf("\n✅ You reached the end!\n");
-        display_maze(maze);
-        
-        // Score based on path length (shorter is better)
-        int score = POINTS_ROBOT - (steps - optimal_path);
-        if (score < 10) score = 10;
-        
-        printf("\n🎯 Path length: %d steps\n", steps);
-        printf("🎯 Score earned: %d points\n", score);
-        
-        if (current_player.robot_score == 0) {
-            current_player.challenges_completed++;
-        }
-        
-        if (score > current_player.robot_score) {
-            current_player.total_score = current_player.total_score - current_player.robot_score + score;
-            current_player.robot_score = score;
-            save_player_scores(&current_player);
-            printf("🏆 New personal best!\n");
-        }
-    } else {
-        printf("\n❌ Invalid path! You hit a wall or didn't reach the end.\n");
-        display_maze(maze);
+    while (sessions) {
+        server_drop(epfd, &sessions, sessions);
     }
+    close(epfd);
+    close(listen_fd);
+    if (strncmp(address, "unix:", 5) == 0) unlink(address + 5);
     
-    pause_screen();
+    printf("\n🛑 Server stopped.\n");
+    return 0;
 }
 
+#endif
+
 /*
 ================================================================================
-    CHALLENGE 4: TRI ULTIME
-    Sort an array with limited operations
+    GAME STATE
+    Opening and closing everything the sessions share
 ================================================================================
 */
 
-void challenge_tri_ultime() {
-    clear_screen();
-    display_header("CHALLENGE 4: Tri Ultime");
-    
-    printf("🎯 Objective: Sort the array using swap operations\n");
-    printf("   Minimize the number of swaps!\n\n");
-    
-    // Generate random array
-    int arr[8];
-    int n = 8;
-    int used[90] = {0}; // Track used numbers (10-99)
-    
-    for(int i = 0; i < n; i++) {
-        int num;
-        do {
-            num = (rand() % 90) + 10; // 10-99
-        } while(used[num - 10]);
-        used[num - 10] = 1;
-        arr[i] = num;
+void game_state_open() {
+    leaderboard_init(&leaderboard);
+    score_stats_init();
+    hanoi_table_init();
+    score_store.on_load = on_score_record_changed;
+    // A snapshot that still matches the store replaces indexing it
+    if (snapshot_open(&score_snapshot, SNAPSHOT_FILE, SCORES_DB_FILE, USERS_FILE)) {
+        if (snapshot_restore_stats(&score_snapshot)) {
+            score_store.snapshot = user_registry.snapshot = &score_snapshot;
+            rankings_pending = 1;
+        } else {
+            snapshot_close(&score_snapshot);
+        }
     }
-    
-    printf("Initial array: ");
-    for(int i = 0; i < n; i++) {
-        printf("%d ", arr[i]);
+    if (!store_open(&score_store, SCORES_DB_FILE, SCORES_FILE)) {
+        printf("⚠️  Could not open %s, scores will not be saved.\n", SCORES_DB_FILE);
     }
-    printf("\n\n");
-    
-    printf("Enter swap operations (format: index1 index2, e.g., 0 1)\n");
-    printf("Type 'done' when finished, 'skip' to skip\n\n");
-    
-    int swaps = 0;
-    char input[100];
+    wal_open(&score_wal, SCORES_WAL_FILE, &score_store);
+    if (!registry_load(&user_registry, USERS_FILE)) {
+        printf("⚠️  Could not open %s, new users will not be saved.\n", USERS_FILE);
+    }
+    catalog_open(&puzzle_catalog, CATALOG_FILE); // Optional; puzzles are solved live without it
+    timing_load(TIMINGS_FILE);
+    if (!window_open(&window_boards, WINDOWS_FILE)) {
+        printf("⚠️  Could not open %s, daily and weekly boards will not be kept.\n", WINDOWS_FILE);
+    }
+}
+
+void game_state_close() {
+    catalog_close(&puzzle_catalog);
+    window_close(&window_boards);
+    attempt_log_close(&attempt_log);
+    timing_save(TIMINGS_FILE);
+    wal_close(&score_wal);
+    if (score_wal.failed > 0) {
+        printf("⚠️  %llu score update%s could not be written to %s and went straight to %s",
+               (unsigned long long)score_wal.failed, score_wal.failed == 1 ? "" : "s", SCORES_WAL_FILE, SCORES_DB_FILE);
+        if (score_wal.lost > 0) printf("; %llu may be lost in a crash", (unsigned long long)score_wal.lost);
+        printf(".\n");
+    }
+    if (!snapshot_save(SNAPSHOT_FILE, SCORES_DB_FILE, USERS_FILE, &score_store, &user_registry)) {
+        printf("⚠️  Could not write %s, the next start will index the store again.\n", SNAPSHOT_FILE);
+    }
+    registry_close(&user_registry);
+    store_close(&score_store);
+    snapshot_close(&score_snapshot);
+    score_store.snapshot = user_registry.snapshot = NULL;
+    rankings_pending = 0;
+    score_columns_free(&score_columns);
+    leaderboard_free(&leaderboard);
+}
+
+/*
+================================================================================
+    STORAGE BENCHMARK
+    --bench-store: a generated population, and latency percentiles for the
+    functions every session calls
+================================================================================
+*/
+
+const char* BENCH_FIRST_NAMES[] = {
+    "Alice", "Bob", "Chloe", "David", "Emma", "Farid", "Gabriel", "Hugo",
+    "Ines", "Jade", "Karim", "Louise", "Mathis", "Nora", "Oscar", "Paul",
+    "Quentin", "Rose", "Sami", "Theo", "Ugo", "Victor", "Wassim", "Yanis",
+    "Zoe", "Adam", "Lina", "Nathan", "Sarah", "Tom", "Lea", "Noah"
+};
+#define BENCH_FIRST_NAME_COUNT (int)(sizeof(BENCH_FIRST_NAMES) / sizeof(BENCH_FIRST_NAMES[0]))
+
+// Player i of a generated population; distinct for every i
+void bench_player_name(char* name, size_t size, long long i) {
+    snprintf(name, size, "%s%lld", BENCH_FIRST_NAMES[i % BENCH_FIRST_NAME_COUNT], i / BENCH_FIRST_NAME_COUNT);
+}
+
+// Write users.txt and the legacy scores.txt for a population. Most players
+// have tried a few challenges; scores lean towards the top of each range
+int bench_generate(long long players, uint64_t seed) {
+    FILE* users = fopen(USERS_FILE, "w");
+    FILE* scores = fopen(SCORES_FILE, "w");
+    if (!users || !scores) {
+        if (users) fclose(users);
+        if (scores) fclose(scores);
+        return 0;
+    }
+    static char users_buffer[1 << 16], scores_buffer[1 << 16];
+    setvbuf(users, users_buffer, _IOFBF, sizeof(users_buffer));
+    setvbuf(scores, scores_buffer, _IOFBF, sizeof(scores_buffer));
     
-    while(1) {
-        printf("Current array: ");
-        for(int i = 0; i < n; i++) {
-            printf("%d ", arr[i]);
-        }
-        printf("\n");
-        
-        printf("Swap (or 'done'/'skip'): ");
-        fgets(input, sizeof(input), stdin);
-        input[strcspn(input, "\n")] = 0;
-        
-        if (strcmp(input, "done") == 0) break;
-        if (strcmp(input, "skip") == 0) {
-            printf("\n❌ Challenge skipped!\n");
-            pause_screen();
-            return;
-        }
+    char name[MAX_NAME_LENGTH];
+    for(long long i = 0; i < players; i++) {
+        bench_player_name(name, sizeof(name), i);
+        fprintf(users, "%s\n", name);
         
-        int idx1, idx2;
-        if (sscanf(input, "%d %d", &idx1, &idx2) == 2) {
-            if (idx1 >= 0 && idx1 < n && idx2 >= 0 && idx2 < n) {
-                int temp = arr[idx1];
-                arr[idx1] = arr[idx2];
-                arr[idx2] = temp;
-                swaps++;
-            } else {
-                printf("❌ Invalid indices!\n");
-            }
-        } else {
-            printf("❌ Invalid format!\n");
+        int values[STORE_SCORE_SLOTS] = { 0 };
+        int total = 0, completed = 0;
+        for(int c = 0; c < CHALLENGE_COUNT; c++) {
+            uint64_t r = maze_random(&seed);
+            if (r % 100 >= 60) continue;
+            int max = CHALLENGES[c].max_points;
+            int a = (int)((r >> 8) % max), b = (int)((r >> 24) % max);
+            values[c] = (a > b ? a : b) + 1;
+            total += values[c];
+            completed++;
         }
+        fprintf(scores, "%s,%d,%d,%d,%d,%d,%d,%d\n", name,
+                values[CHALLENGE_COMPTE_BON], values[CHALLENGE_MASTERMIND], values[CHALLENGE_ROBOT],
+                values[CHALLENGE_TRI], values[CHALLENGE_HANOI], total, completed);
+    }
+    int ok = !ferror(users) && !ferror(scores);
+    fclose(users);
+    fclose(scores);
+    return ok;
+}
+
+long long bench_pick(StoreBench* bench) {
+    return (long long)(maze_random(&bench->rng) % (uint64_t)bench->players);
+}
+
+void bench_prepare_known_name(StoreBench* bench) {
+    bench_player_name(bench->name, sizeof(bench->name), bench_pick(bench));
+}
+
+void bench_prepare_unknown_name(StoreBench* bench) {
+    snprintf(bench->name, sizeof(bench->name), "Nobody%lld", bench_pick(bench));
+}
+
+void bench_run_user_exists(StoreBench* bench) {
+    bench->found += user_exists(bench->name);
+}
+
+void bench_prepare_load(StoreBench* bench) {
+    bench_prepare_known_name(bench);
+    initialize_player(&bench->player, bench->name);
+}
+
+void bench_run_load(StoreBench* bench) {
+    load_player_scores(&bench->player);
+    bench->found += bench->player.total_score;
+}
+
+// A loaded player with one challenge's score changed, as after a new best
+void bench_prepare_save(StoreBench* bench) {
+    bench_prepare_load(bench);
+    load_player_scores(&bench->player);
+    Player* player = &bench->player;
+    int challenge = (int)(maze_random(&bench->rng) % CHALLENGE_COUNT);
+    if (player->scores[challenge] == 0) player->challenges_completed++;
+    int score = 1 + (int)(maze_random(&bench->rng) % CHALLENGES[challenge].max_points);
+    player->total_score += score - player->scores[challenge];
+    player->scores[challenge] = score;
+}
+
+void bench_run_save(StoreBench* bench) {
+    save_player_scores(&bench->player);
+}
+
+// Drop the previous frame so every call renders into empty buffers
+void bench_prepare_page(StoreBench* bench) {
+    Session* s = bench->session;
+    s->out.len = 0;
+    s->game.leaderboard.challenge = -1;
+    s->game.leaderboard.window = 0;
+    s->game.leaderboard.page = (int)(maze_random(&bench->rng) % (uint64_t)(bench->players / LEADERBOARD_PAGE_SIZE + 1));
+}
+
+void bench_prepare_challenge_board(StoreBench* bench) {
+    bench_prepare_page(bench);
+    bench->session->game.leaderboard.challenge = (int)(maze_random(&bench->rng) % CHALLENGE_COUNT);
+}
+
+void bench_run_leaderboard(StoreBench* bench) {
+    display_leaderboard(bench->session);
+}
+
+const StoreBenchCase STORE_BENCH_CASES[] = {
+    { "user_exists_hit",       bench_prepare_known_name,      bench_run_user_exists },
+    { "user_exists_miss",      bench_prepare_unknown_name,    bench_run_user_exists },
+    { "load_player_scores",    bench_prepare_load,            bench_run_load },
+    { "save_player_scores",    bench_prepare_save,            bench_run_save },
+    { "display_leaderboard",   bench_prepare_page,            bench_run_leaderboard },
+    { "challenge_leaderboard", bench_prepare_challenge_board, bench_run_leaderboard }
+};
+
+// One JSON object per line, so runs can be diffed and plotted
+void bench_report(const char* name, long long players, const LogHistogram* h, int64_t total_ns, int64_t max_ns) {
+    printf("{\"benchmark\":\"%s\",\"players\":%lld,\"samples\":%llu,\"mean_ns\":%lld,"
+           "\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%lld}\n",
+           name, players, (unsigned long long)h->count,
+           h->count ? (long long)(total_ns / (int64_t)h->count) : 0LL,
+           (unsigned long long)log_histogram_quantile(h, 0.50),
+           (unsigned long long)log_histogram_quantile(h, 0.90),
+           (unsigned long long)log_histogram_quantile(h, 0.99), (long long)max_ns);
+    fflush(stdout);
+}
+
+// --bench-store PLAYERS [REPS] [DIR]: generate a population in DIR (once),
+// then time each case after a warm-up
+int store_bench_main(int argc, char** argv) {
+    long long players = argc > 2 ? atoll(argv[2]) : 1000;
+    int reps = argc > 3 ? atoi(argv[3]) : STORE_BENCH_REPS;
+    char dir[64];
+    if (argc > 4) snprintf(dir, sizeof(dir), "%s", argv[4]);
+    else snprintf(dir, sizeof(dir), "bench-%lld", players);
+    if (players < 1 || players > INT32_MAX || reps < 1) {
+        printf("Usage: %s --bench-store PLAYERS [REPS] [DIR]\n", argv[0]);
+        return 2;
     }
     
-    // Check if sorted
-    int sorted = 1;
-    for(int i = 0; i < n - 1; i++) {
-        if (arr[i] > arr[i+1]) {
-            sorted = 0;
-            break;
-        }
+    if (!enter_directory(dir)) {
+        printf("❌ Could not use directory %s.\n", dir);
+        return 1;
     }
     
-    if (sorted) {
-        // Score based on number of swaps (fewer is better)
-        // Use difficulty-based scoring: fewer swaps = higher score
-        int score = POINTS_TRI - (swaps / 2);
-        if (score < 5) score = 5;
-        
-        printf("\n✅ Array sorted successfully!\n");
-        printf("🎯 Number of swaps: %d\n", swaps);
-        printf("🎯 Score earned: %d points\n", score);
-        
-        if (current_player.tri_score == 0) {
-            current_player.challenges_completed++;
+    // The first run in a directory also pays for importing the CSV
+    LogHistogram* h = calloc(1, sizeof(LogHistogram));
+    if (!h) return 1;
+    struct stat existing;
+    int fresh = stat(SCORES_DB_FILE, &existing) != 0;
+    if (fresh) {
+        int64_t started = clock_now_ns();
+        if (!bench_generate(players, 42)) {
+            printf("❌ Could not write the population to %s.\n", dir);
+            free(h);
+            return 1;
         }
-        
-        if (score > current_player.tri_score) {
-            current_player.total_score = current_player.total_score - current_player.tri_score + score;
-            current_player.tri_score = score;
-            save_player_scores(&current_player);
-            printf("🏆 New personal best!\n");
+        int64_t elapsed = clock_now_ns() - started;
+        log_histogram_add(h, elapsed);
+        bench_report("generate", players, h, elapsed, elapsed);
+    }
+    
+    memset(h, 0, sizeof(*h));
+    int64_t started = clock_now_ns();
+    game_state_open();
+    int64_t elapsed = clock_now_ns() - started;
+    log_histogram_add(h, elapsed);
+    bench_report(fresh ? "startup_import" : "startup", players, h, elapsed, elapsed);
+    
+    StoreBench bench = { .players = players, .rng = 7 };
+    bench.session = session_create(-1);
+    if (!bench.session) {
+        game_state_close();
+        free(h);
+        return 1;
+    }
+    
+    int warmup = reps * STORE_BENCH_WARMUP_PERCENT / 100;
+    int64_t budget = STORE_BENCH_BUDGET_SECONDS * NS_PER_SECOND;
+    for(size_t c = 0; c < sizeof(STORE_BENCH_CASES) / sizeof(STORE_BENCH_CASES[0]); c++) {
+        const StoreBenchCase* test = &STORE_BENCH_CASES[c];
+        memset(h, 0, sizeof(*h));
+        int64_t total = 0, max = 0;
+        int64_t warmup_end = clock_now_ns() + budget / 5;
+        int64_t deadline = clock_now_ns() + budget;
+        for(int i = 0; h->count < (uint64_t)reps; i++) {
+            test->prepare(&bench);
+            int64_t before = clock_now_ns();
+            test->run(&bench);
+            int64_t ns = clock_now_ns() - before;
+            // Warm-up ends after its share of the calls or a fifth of the budget
+            if (i < warmup && before < warmup_end) continue;
+            log_histogram_add(h, ns);
+            total += ns;
+            if (ns > max) max = ns;
+            if (before > deadline) break;
         }
-    } else {
-        printf("\n❌ Array is not sorted correctly!\n");
+        bench_report(test->name, players, h, total, max);
     }
     
-    pause_screen();
+    session_free(bench.session);
+    game_state_close();
+    free(h);
+    return 0;
 }
 
 /*
 ================================================================================
-    CHALLENGE 5: TOUR DE HANOI
-    Solve the Tower of Hanoi puzzle
+    LOAD TEST
+    --load-test: simulated players drive whole sessions through the same
+    state machine as the terminal and the server, one solver per challenge
 ================================================================================
 */
 
-void display_hanoi_state(int towers[3][10], int counts[3], int disks) {
-    printf("\n");
-    for(int level = disks - 1; level >= 0; level--) {
-        printf("  ");
-        for(int tower = 0; tower < 3; tower++) {
-            if (counts[tower] > level) {
-                int disk = towers[tower][level];
-                for(int i = 0; i < disk; i++) printf("█");
-                for(int i = disk; i < disks; i++) printf(" ");
-            } else {
-                for(int i = 0; i < disks; i++) printf(" ");
-            }
-            printf("  ");
-        }
-        printf("\n");
-    }
-    printf("  ");
-    for(int i = 0; i < disks; i++) printf("═");
-    printf("  ");
-    for(int i = 0; i < disks; i++) printf("═");
-    printf("  ");
-    for(int i = 0; i < disks; i++) printf("═");
-    printf("\n");
-    printf("     A");
-    for(int i = 0; i < disks - 1; i++) printf(" ");
-    printf("    B");
-    for(int i = 0; i < disks - 1; i++) printf(" ");
-    printf("    C\n");
+// LOAD_OP_PLAY entries are named after their challenge
+const char* LOAD_OP_NAMES[LOAD_OP_COUNT] = {
+    [LOAD_OP_LOGIN]       = "Login",
+    [LOAD_OP_MENU]        = "Menu",
+    [LOAD_OP_SETUP]       = "Setup",
+    [LOAD_OP_LEADERBOARD] = "Leaderboard",
+    [LOAD_OP_STATS]       = "Stats",
+    [LOAD_OP_CONTINUE]    = "Continue",
+    [LOAD_OP_EXIT]        = "Exit"
+};
+
+// Leaderboard commands a bot picks from; "c" is followed by a challenge
+const char* LOAD_BOARD_INPUTS[] = { "n", "p", "me", "c", "day", "week", "season", "all" };
+
+uint64_t load_random(LoadBot* bot, uint64_t bound) {
+    return maze_random(&bot->rng) % bound;
+}
+
+// Whether this decision goes the solver's way
+int load_skilled(const LoadTest* test, LoadBot* bot) {
+    return (int)load_random(bot, 1000) < test->skill;
 }
 
-void challenge_tour_hanoi() {
-    clear_screen();
-    display_header("CHALLENGE 5: Tour de Hanoi");
+// Open a session on the login screen, with every challenge, the
+// leaderboard and the statistics to visit once each, in a random order
+int load_bot_start(LoadTest* test, LoadBot* bot) {
+    bot->session = session_create(-1);
+    if (!bot->session) return 0;
     
-    printf("🎯 Objective: Move all disks from tower A to tower C\n");
-    printf("   Rules:\n");
-    printf("   • Only one disk can be moved at a time\n");
-    printf("   • A larger disk cannot be placed on a smaller disk\n\n");
+    bot->planned = 0;
+    for(int choice = 1; choice < MENU_EXIT; choice++) bot->plan[bot->planned++] = choice;
+    for(int i = bot->planned - 1; i > 0; i--) {
+        int j = (int)load_random(bot, i + 1);
+        int temp = bot->plan[i];
+        bot->plan[i] = bot->plan[j];
+        bot->plan[j] = temp;
+    }
+    bot->next = 0;
+    bot->session_started = clock_now_ns();
+    test->started++;
     
-    // Randomize number of disks (3-5)
-    int disks = (rand() % 3) + 3;
-    int towers[3][10] = {0};
-    int counts[3] = {disks, 0, 0};
+    login_start(bot->session);
+    test->bytes += bot->session->out.len;
+    bot->session->out.len = 0;
+    return 1;
+}
+
+// Le Compte est Bon: the solver's closest expression, or a lone number
+void load_play_compte_bon(LoadTest* test, LoadBot* bot) {
+    CompteBonGame* game = &bot->session->game.compte_bon;
+    CompteBonSolver solver;
     
-    // Initialize tower A with disks (largest to smallest)
-    for(int i = 0; i < disks; i++) {
-        towers[0][i] = disks - i;
+    if (load_skilled(test, bot) && solver_solve(&solver, game->numbers, COMPTE_BON_NUMBERS, game->target)) {
+        char solution[SOLVER_EXPRESSION_MAX];
+        solver_solution(&solver, solution, sizeof(solution));
+        solver_free(&solver);
+        text_append(&bot->line, solution, strlen(solution));
+    } else {
+        text_printf(&bot->line, "%d", game->numbers[COMPTE_BON_NUMBERS - 1]);
     }
+}
+
+// Mastermind: a code that fits every feedback so far, or a random one;
+// an unskilled bot may ask for one hint per game
+void load_play_mastermind(LoadTest* test, LoadBot* bot) {
+    MastermindGame* game = &bot->session->game.mastermind;
+    const MastermindVariant* v = &MASTERMIND_VARIANTS[game->variant];
+    const MastermindTable* table = game->engine.table;
     
-    display_hanoi_state(towers, counts, disks);
-    
-    int moves = 0;
-    int min_moves = (1 << disks) - 1; // 2^n - 1
+    if (game->hints == 0 && !load_skilled(test, bot)) {
+        text_append(&bot->line, "hint", 4);
+        return;
+    }
     
-    printf("\nMinimum possible moves: %d\n", min_moves);
-    printf("\nEnter moves (format: A B to move from tower A to B)\n");
-    printf("Type 'skip' to skip\n\n");
+    uint32_t code = 0;
+    if (load_skilled(test, bot)) mastermind_engine_sample(&game->engine, &code, 1);
+    else code = (uint32_t)load_random(bot, table->count);
+    for(int i = 0; i < v->pegs; i++) text_printf(&bot->line, "%d", table->digits[code][i] + v->first_color);
+}
+
+// Append count moves in one direction, the way a player would shorten them
+void load_path_run(TextBuffer* line, char direction, int count) {
+    if (count == 1) text_append(line, &direction, 1);
+    else if (count > 1) text_printf(line, "%c%d", direction, count);
+}
+
+// Course de Robots: follow the distance field down to the goal, taking a
+// random open neighbour instead on each unskilled step
+void load_play_robot(LoadTest* test, LoadBot* bot) {
+    static const int steps[4][2] = { { -1, 0 }, { 1, 0 }, { 0, 1 }, { 0, -1 } };
+    static const char directions[4] = { 'N', 'S', 'E', 'O' };
+    const Maze* maze = &bot->session->game.robot.maze;
+    int row = 0, col = 0, run = 0;
+    char last = 0;
     
-    while(1) {
-        if (counts[2] == disks) {
-            // Win condition
-            printf("\n✅ Congratulations! You solved the Tower of Hanoi!\n");
-            
-            // Score based on number of moves
-            int score = POINTS_HANOI - (moves - min_moves) * 2;
-            if (score < 10) score = 10;
-            
-            printf("🎯 Moves used: %d (optimal: %d)\n", moves, min_moves);
-            printf("🎯 Score earned: %d points\n", score);
-            
-            if (current_player.hanoi_score == 0) {
-                current_player.challenges_completed++;
-            }
-            
-            if (score > current_player.hanoi_score) {
-                current_player.total_score = current_player.total_score - current_player.hanoi_score + score;
-                current_player.hanoi_score = score;
-                save_player_scores(&current_player);
-                printf("🏆 New personal best!\n");
-            }
-            break;
-        }
-        
-        printf("Move: ");
-        char input[10];
-        fgets(input, sizeof(input), stdin);
-        input[strcspn(input, "\n")] = 0;
-        
-        if (strcmp(input, "skip") == 0) {
-            printf("\n❌ Challenge skipped!\n");
-            pause_screen();
-            return;
+    long long limit = 4LL * maze->optimal + 64;
+    for(long long step = 0; step < limit && (row != maze->goal_row || col != maze->goal_col); step++) {
+        uint32_t here = maze->distance[(size_t)row * maze->cols + col];
+        int open[4], count = 0, closer = -1;
+        for(int d = 0; d < 4; d++) {
+            int r = row + steps[d][0], c = col + steps[d][1];
+            if (!maze_is_open(maze, r, c)) continue;
+            open[count++] = d;
+            if (maze->distance[(size_t)r * maze->cols + c] + 1 == here) closer = d;
         }
+        if (count == 0) break;
         
-        char from, to;
-        if (sscanf(input, "%c %c", &from, &to) == 2) {
-            from = toupper(from);
-            to = toupper(to);
-            
-            int from_idx = from - 'A';
-            int to_idx = to - 'A';
-            
-            if (from_idx < 0 || from_idx > 2 || to_idx < 0 || to_idx > 2) {
-                printf("❌ Invalid towers! Use A, B, or C.\n");
-                continue;
-            }
-            
-            if (counts[from_idx] == 0) {
-                printf("❌ Source tower is empty!\n");
-                continue;
-            }
-            
-            int disk = towers[from_idx][counts[from_idx] - 1];
-            
-            if (counts[to_idx] > 0 && towers[to_idx][counts[to_idx] - 1] < disk) {
-                printf("❌ Cannot place larger disk on smaller disk!\n");
-                continue;
-            }
-            
-            // Valid move
-            towers[from_idx][counts[from_idx] - 1] = 0;
-            counts[from_idx]--;
-            towers[to_idx][counts[to_idx]] = disk;
-            counts[to_idx]++;
-            moves++;
-            
-            display_hanoi_state(towers, counts, disks);
-        } else {
-            printf("❌ Invalid format! Use: A B\n");
+        int d = closer >= 0 && load_skilled(test, bot) ? closer : open[load_random(bot, count)];
+        if (directions[d] != last) {
+            load_path_run(&bot->line, last, run);
+            last = directions[d];
+            run = 0;
         }
+        run++;
+        row += steps[d][0];
+        col += steps[d][1];
     }
-    
-    pause_screen();
+    load_path_run(&bot->line, last, run);
+    if (bot->line.len == 0) text_append(&bot->line, "skip", 4);
 }
 
-/*
-================================================================================
-    LEADERBOARD AND STATISTICS
-================================================================================
-*/
-
-void display_leaderboard() {
-    clear_screen();
-    display_header("🏆 GLOBAL LEADERBOARD 🏆");
+// Tri Ultime with swaps: move the first misplaced element's rightful value
+// into place, which is optimal, or swap two at random; 'done' once sorted
+void load_play_tri(LoadTest* test, LoadBot* bot) {
+    TriGame* game = &bot->session->game.tri;
+    int n = game->n;
     
-    FILE* file = fopen(SCORES_FILE, "r");
-    if (!file) {
-        printf("No scores recorded yet!\n");
-        pause_screen();
+    if (game->descents == 0 || bot->moves > 3LL * n) {
+        text_append(&bot->line, "done", 4);
         return;
     }
     
-    Player players[MAX_PLAYERS];
-    int count = 0;
+    int* rank = load_skilled(test, bot) ? tri_ranks(game->arr, n) : NULL;
+    if (!rank) {
+        int a = (int)load_random(bot, n), b = (int)load_random(bot, n - 1);
+        text_printf(&bot->line, "%d %d", a, b >= a ? b + 1 : b);
+        return;
+    }
+    int i = 0, j = 0;
+    while (i < n && rank[i] == i) i++;
+    while (j < n && rank[j] != i) j++;
+    text_printf(&bot->line, "%d %d", i, j);
+    free(rank);
+}
+
+// Tour de Hanoi: the largest disk off the last tower goes there once the
+// smaller ones are out of the way, otherwise they head for the spare
+// tower; this solves three towers from any position. An unskilled step
+// is a random legal move.
+void load_play_hanoi(LoadTest* test, LoadBot* bot) {
+    HanoiGame* game = &bot->session->game.hanoi;
+    int from = -1, to = -1;
     
-    char name[MAX_NAME_LENGTH];
-    int cb, mm, rb, tr, hn, tot, comp;
+    if (bot->moves > 4 * (long long)game->min_moves + 16) {
+        text_append(&bot->line, "skip", 4);
+        return;
+    }
     
-    while (fscanf(file, "%[^,],%d,%d,%d,%d,%d,%d,%d\n",
-                  name, &cb, &mm, &rb, &tr, &hn, &tot, &comp) == 8 && count < MAX_PLAYERS) {
-        strcpy(players[count].name, name);
-        players[count].total_score = tot;
-        players[count].challenges_completed = comp;
-        count++;
+    if (game->peg_count == 3 && load_skilled(test, bot)) {
+        int target = 2;
+        for(int d = game->disks; d >= 1 && from < 0; d--) {
+            uint64_t disk = 1ull << (d - 1);
+            int peg = game->pegs[0] & disk ? 0 : game->pegs[1] & disk ? 1 : 2;
+            if (peg == target) continue;
+            if (!((game->pegs[peg] | game->pegs[target]) & (disk - 1))) {
+                from = peg;
+                to = target;
+            } else {
+                target = 3 - peg - target;
+            }
+        }
     }
-    fclose(file);
     
-    // Sort by total score
-    for(int i = 0; i < count - 1; i++) {
-        for(int j = 0; j < count - i - 1; j++) {
-            if (players[j].total_score < players[j+1].total_score) {
-                Player temp = players[j];
-                players[j] = players[j+1];
-                players[j+1] = temp;
+    if (from < 0) {
+        int moves[HANOI_MAX_PEGS * HANOI_MAX_PEGS][2];
+        int count = 0;
+        for(int a = 0; a < game->peg_count; a++) {
+            uint64_t disk = game->pegs[a] & -game->pegs[a];
+            for(int b = 0; b < game->peg_count && disk; b++) {
+                uint64_t top = game->pegs[b] & -game->pegs[b];
+                if (a == b || (top && top < disk)) continue;
+                moves[count][0] = a;
+                moves[count++][1] = b;
             }
         }
+        int pick = (int)load_random(bot, count);
+        from = moves[pick][0];
+        to = moves[pick][1];
+    }
+    text_printf(&bot->line, "%c %c", 'A' + from, 'A' + to);
+}
+
+// Write the bot's next line for the screen its session is on, and say
+// what the line asks for
+LoadOp load_bot_line(LoadTest* test, LoadBot* bot) {
+    Session* s = bot->session;
+    bot->line.len = 0;
+    
+    switch(s->screen) {
+        case SCREEN_LOGIN:
+            text_printf(&bot->line, "bot%d", bot->id);
+            return LOAD_OP_LOGIN;
+        case SCREEN_MENU: {
+            int choice = bot->next < bot->planned ? bot->plan[bot->next++] : MENU_EXIT;
+            text_printf(&bot->line, "%d", choice);
+            bot->moves = 0;
+            bot->board_commands = LOAD_BOARD_COMMANDS;
+            return choice == MENU_LEADERBOARD ? LOAD_OP_LEADERBOARD :
+                   choice == MENU_STATS ? LOAD_OP_STATS :
+                   choice == MENU_EXIT ? LOAD_OP_EXIT : LOAD_OP_MENU;
+        }
+        case SCREEN_LEADERBOARD:
+            // An empty line goes back to the menu
+            if (bot->board_commands-- > 0) {
+                const char* input = LOAD_BOARD_INPUTS[load_random(bot, sizeof(LOAD_BOARD_INPUTS) / sizeof(LOAD_BOARD_INPUTS[0]))];
+                text_append(&bot->line, input, strlen(input));
+                if (strcmp(input, "c") == 0) text_printf(&bot->line, " %d", 1 + (int)load_random(bot, CHALLENGE_COUNT));
+            }
+            return LOAD_OP_LEADERBOARD;
+        case SCREEN_COMPTE_BON_LEVEL:
+        case SCREEN_MASTERMIND_VARIANT:
+        case SCREEN_ROBOT_SIZE:
+        case SCREEN_TRI_SETUP:
+        case SCREEN_HANOI_SIZE:
+            return LOAD_OP_SETUP; // Enter: each challenge's default
+        default:
+            break;
+    }
+    
+    int challenge = screen_challenge(s->screen);
+    if (challenge < 0) return LOAD_OP_CONTINUE;
+    bot->moves++;
+    switch(challenge) {
+        case CHALLENGE_COMPTE_BON: load_play_compte_bon(test, bot); break;
+        case CHALLENGE_MASTERMIND: load_play_mastermind(test, bot); break;
+        case CHALLENGE_ROBOT:      load_play_robot(test, bot); break;
+        case CHALLENGE_TRI:        load_play_tri(test, bot); break;
+        case CHALLENGE_HANOI:      load_play_hanoi(test, bot); break;
     }
+    return LOAD_OP_PLAY + challenge;
+}
+
+// Type the bot's next line and time the session handling it; what it
+// renders is counted, then dropped
+void load_bot_step(LoadTest* test, LoadBot* bot) {
+    Session* s = bot->session;
+    LoadOp op = load_bot_line(test, bot);
+    text_append(&bot->line, "\n", 1);
+    
+    int64_t before = clock_now_ns();
+    session_feed(s, bot->line.data, bot->line.len);
+    int64_t ns = clock_now_ns() - before;
     
-    printf("╔════╦══════════════════════════╦══════════════╦════════════════════╗\n");
-    printf("║ #  ║ Player Name              ║ Total Score  ║ Challenges Done    ║\n");
-    printf("╠════╬══════════════════════════╬══════════════╬════════════════════╣\n");
+    log_histogram_add(&test->ops[op], ns);
+    test->op_total_ns[op] += ns;
+    if (ns > test->op_max_ns[op]) test->op_max_ns[op] = ns;
+    test->lines++;
+    test->bytes += s->out.len;
+    s->out.len = 0;
+}
+
+// A quantile read from its bucket can round past the largest value seen
+double load_quantile_us(const LogHistogram* h, double q, int64_t max_ns) {
+    uint64_t ns = log_histogram_quantile(h, q);
+    return (ns > (uint64_t)max_ns ? (uint64_t)max_ns : ns) / 1000.0;
+}
+
+void load_report(const LoadTest* test, double seconds) {
+    char count[32], lines[32], p50[32], p99[32];
+    const LogHistogram* sessions = &test->session_ns;
+    int64_t handling = 0;
+    for(int op = 0; op < LOAD_OP_COUNT; op++) handling += test->op_total_ns[op];
     
-    for(int i = 0; i < count && i < 10; i++) {
-        printf("║ %-2d ║ %-24s ║ %-12d ║ %-18d ║\n",
-               i + 1, players[i].name, players[i].total_score, players[i].challenges_completed);
+    printf("\n%s sessions in %.2f s: %.1f sessions/s, %s lines (%.0f lines/s), %.1f MB rendered\n",
+           format_count(count, test->finished), seconds, test->finished / seconds,
+           format_count(lines, (long long)test->lines), test->lines / seconds, test->bytes / 1e6);
+    printf("Handling the lines took %.2f s; the rest went to the bots' solvers and think time\n",
+           handling / 1e9);
+    if (sessions->count > 0) {
+        printf("Session length: p50 %s, p99 %s\n",
+               format_duration(p50, sizeof(p50), log_histogram_quantile(sessions, 0.50)),
+               format_duration(p99, sizeof(p99), log_histogram_quantile(sessions, 0.99)));
     }
     
-    printf("╚════╩══════════════════════════╩══════════════╩════════════════════╝\n");
+    printf("\n%-12s %12s %9s %9s %9s %9s %9s %9s\n", "Operation", "Lines", "Mean µs",
+           "p50 µs", "p90 µs", "p99 µs", "p99.9 µs", "Max µs");
+    for(int op = 0; op < LOAD_OP_COUNT; op++) {
+        const LogHistogram* h = &test->ops[op];
+        if (h->count == 0) continue;
+        const char* name = op >= LOAD_OP_PLAY && op < LOAD_OP_LEADERBOARD ?
+                           CHALLENGES[op - LOAD_OP_PLAY].short_name : LOAD_OP_NAMES[op];
+        printf("%-12s %12s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, format_count(count, (long long)h->count),
+               test->op_total_ns[op] / 1000.0 / h->count,
+               load_quantile_us(h, 0.50, test->op_max_ns[op]),
+               load_quantile_us(h, 0.90, test->op_max_ns[op]),
+               load_quantile_us(h, 0.99, test->op_max_ns[op]),
+               load_quantile_us(h, 0.999, test->op_max_ns[op]),
+               test->op_max_ns[op] / 1000.0);
+    }
     
-    pause_screen();
+    // Saves only reach the store through the log's writer thread
+    const WriteAheadLog* wal = &score_wal;
+    printf("\nScore saves: %s in %s group commits (%.1f per commit), at most %d queued\n",
+           format_count(count, (long long)wal->batched), format_count(lines, (long long)wal->batches),
+           wal->batches ? (double)wal->batched / wal->batches : 0.0, wal->queue_peak);
+    printf("Store lock: %llu saves waited for the writer (%.2f%%), %.1f µs blocked in all\n",
+           (unsigned long long)wal->lock_waits, wal->batched ? wal->lock_waits * 100.0 / wal->batched : 0.0,
+           wal->lock_wait_ns / 1000.0);
 }
 
-void display_player_stats() {
-    clear_screen();
-    display_header("📊 YOUR STATISTICS 📊");
+int load_test_main(int argc, char** argv) {
+    int bots = argc > 2 ? atoi(argv[2]) : LOAD_DEFAULT_BOTS;
+    long long sessions = argc > 3 ? atoll(argv[3]) : (long long)bots * LOAD_SESSIONS_PER_BOT;
+    double skill = argc > 4 ? atof(argv[4]) : LOAD_DEFAULT_SKILL;
+    int think_ms = argc > 5 ? atoi(argv[5]) : 0;
+    const char* dir = argc > 6 ? argv[6] : LOAD_DEFAULT_DIR;
+    if (bots < 1 || bots > LOAD_MAX_BOTS || sessions < 1 || skill < 0 || skill > 1 || think_ms < 0) {
+        printf("Usage: %s --load-test [BOTS] [SESSIONS] [SKILL 0-1] [THINK_MS] [DIR]\n", argv[0]);
+        return 2;
+    }
+    if (!enter_directory(dir)) {
+        printf("❌ Could not use directory %s.\n", dir);
+        return 1;
+    }
+    
+    LoadTest* test = calloc(1, sizeof(LoadTest));
+    LoadBot* all = calloc(bots, sizeof(LoadBot));
+    if (!test || !all) {
+        free(test);
+        free(all);
+        return 1;
+    }
+    test->bots = all;
+    test->bot_count = bots;
+    test->sessions = sessions;
+    test->skill = (int)(skill * 1000 + 0.5);
+    test->think_ms = think_ms;
     
-    printf("Player: %s\n\n", current_player.name);
+    game_state_open();
+    printf("🤖 %d bots playing %lld sessions in %s (skill %.2f, think time %d ms)\n",
+           bots, sessions, dir, skill, think_ms);
+    fflush(stdout);
     
-    printf("╔══════════════════════════════════╦═══════════╦════════════╗\n");
-    printf("║ Challenge                        ║ Score     ║ Max Points ║\n");
-    printf("╠══════════════════════════════════╬═══════════╬════════════╣\n");
-    printf("║ 1. Le Compte est Bon             ║ %-9d ║ %-10d ║\n", current_player.compte_bon_score, POINTS_COMPTE_BON);
-    printf("║ 2. Mastermind Algorithmique      ║ %-9d ║ %-10d ║\n", current_player.mastermind_score, POINTS_MASTERMIND);
-    printf("║ 3. Course de Robots              ║ %-9d ║ %-10d ║\n", current_player.robot_score, POINTS_ROBOT);
-    printf("║ 4. Tri Ultime                    ║ %-9d ║ %-10d ║\n", current_player.tri_score, POINTS_TRI);
-    printf("║ 5. Tour de Hanoi                 ║ %-9d ║ %-10d ║\n", current_player.hanoi_score, POINTS_HANOI);
-    printf("╠══════════════════════════════════╬═══════════╬════════════╣\n");
-    printf("║ TOTAL                            ║ %-9d ║ %-10d ║\n", current_player.total_score, POINTS_COMPTE_BON + POINTS_MASTERMIND + POINTS_ROBOT + POINTS_TRI + POINTS_HANOI);
-    printf("╚══════════════════════════════════╩═══════════╩════════════╝\n");
+    // Bots wait in a heap keyed by when they type next, so thousands of
+    // them need no thread each; without think time they take turns
+    int64_t started = clock_now_ns();
+    for(int i = 0; i < bots && test->started < sessions; i++) {
+        LoadBot* bot = &all[i];
+        bot->id = i;
+        bot->rng = (uint64_t)i * 0x9E3779B97F4A7C15ull + 1;
+        if (!load_bot_start(test, bot)) break;
+        heap_push(&test->queue, (uint64_t)i);
+    }
     
-    printf("\n📈 Challenges Completed: %d/5\n", current_player.challenges_completed);
+    while (test->queue.count > 0) {
+        uint64_t key = heap_pop(&test->queue);
+        LoadBot* bot = &all[key & (LOAD_MAX_BOTS - 1)];
+        sleep_ns(started + (int64_t)(key >> 20) * 1000 - clock_now_ns());
+        
+        load_bot_step(test, bot);
+        metrics_poll();
+        
+        if (bot->session->screen == SCREEN_CLOSED) {
+            log_histogram_add(&test->session_ns, clock_now_ns() - bot->session_started);
+            test->finished++;
+            session_free(bot->session);
+            bot->session = NULL;
+            if (test->started >= test->sessions || !load_bot_start(test, bot)) continue;
+        }
+        
+        // Think for between half and one and a half times the mean
+        int64_t think = think_ms > 0 ? (int64_t)think_ms * (500 + (int64_t)load_random(bot, 1001)) * 1000 : 0;
+        uint64_t wake = (uint64_t)(clock_now_ns() + think - started) / 1000;
+        heap_push(&test->queue, wake << 20 | (uint64_t)(bot - all));
+    }
+    double seconds = (clock_now_ns() - started) / 1e9;
     
-    float completion = (current_player.challenges_completed / 5.0) * 100;
-    printf("📊 Completion Rate: %.1f%%\n", completion);
+    for(int i = 0; i < bots; i++) {
+        if (all[i].session) session_free(all[i].session);
+        free(all[i].line.data);
+    }
+    free(test->queue.keys);
+    game_state_close();
+    load_report(test, seconds);
     
-    pause_screen();
+    free(all);
+    free(test);
+    return 0;
 }
 
 /*
 ================================================================================
-    MAIN MENU
+    MAIN FUNCTION
 ================================================================================
 */
 
-void display_main_menu() {
-    clear_screen();
-    display_banner();
-    
-    printf("  ╔═══════════════════════════════════════════════════════════════════════════╗\n");
-    printf("  ║                         🎮 MAIN MENU 🎮                                  ║\n");
-    printf("  ╠═══════════════════════════════════════════════════════════════════════════╣\n");
-    printf("  ║                                                                           ║\n");
-    printf("  ║   1. 🎯 Le Compte est Bon              (Difficulty: ⭐⭐⭐ - 30pts)     ║\n");
-    printf("  ║   2. 🧩 Mastermind Algorithmique       (Difficulty: ⭐⭐⭐ - 25pts)     ║\n");
-    printf("  ║   3. 🤖 Course de Robots               (Difficulty: ⭐⭐⭐⭐⭐ - 50pts)║\n");
-    printf("  ║   4. 📊 Tri Ultime                     (Difficulty: ⭐⭐ - 20pts)        ║\n");
-    printf("  ║   5. 🗼 Tour de Hanoi                  (Difficulty: ⭐⭐⭐⭐ - 40pts)   ║\n");
-    printf("  ║                                                                            ║\n");
-    printf("  ║   6. 🏆 View Leaderboard                                                  ║\n");
-    printf("  ║   7. 📊 View Your Statistics                                              ║\n");
-    printf("  ║   8. 🚪 Exit                                                              ║\n");
-    printf("  ║                                                                           ║\n");
-    printf("  ╚═══════════════════════════════════════════════════════════════════════════╝\n\n");
-    
-    printf("  Player: %s | Total Score: %d | Completed: %d/5\n\n",
-           current_player.name, current_player.total_score, current_player.challenges_completed);
+// Play one session on this terminal
+void run_terminal() {
+    Session* s = session_create(-1);
+    if (!s) return;
+    
+    fflush(stdout);
+    login_start(s);
+    
+    char buf[SESSION_LINE_MAX];
+    while (s->screen != SCREEN_CLOSED) {
+        session_flush(s);
+        if (!fgets(buf, sizeof(buf), stdin)) {
+            // Interrupted by SIGUSR1: dump, then go back to waiting
+            if (ferror(stdin) && errno == EINTR) {
+                clearerr(stdin);
+                metrics_poll();
+                continue;
+            }
+            break;
+        }
+        session_feed(s, buf, strlen(buf));
+        metrics_poll();
+    }
+    
+    session_flush(s);
+    session_free(s);
 }
 
-/*
-================================================================================
-    MAIN FUNCTION
-================================================================================
-*/
-
-int main() {
+int main(int argc, char** argv) {
     // Set console to UTF-8 encoding for Windows
     #ifdef _WIN32
         SetConsoleOutputCP(CP_UTF8);
         SetConsoleCP(CP_UTF8);
+        
+        // Let the console interpret the ANSI sequences the renderer emits
+        HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if (GetConsoleMode(console, &mode)) {
+            SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        }
     #endif
     
     // Seed random number generator once
     srand(time(NULL));
     
-    login_user();
-    
-    int running = 1;
-    while(running) {
-        display_main_menu();
-        
-        printf("  Select option (1-8): ");
-        int choice;
-        scanf("%d", &choice);
-        while(getchar() != '\n'); // Clear input buffer
-        
-        switch(choice) {
-            case CHALLENGE_COMPTE_BON:
-                challenge_compte_bon();
-                break;
-            case CHALLENGE_MASTERMIND:
-                challenge_mastermind();
-                break;
-            case CHALLENGE_ROBOT:
-                challenge_course_robots();
-                break;
-            case CHALLENGE_TRI:
-                challenge_tri_ultime();
-                break;
-            case CHALLENGE_HANOI:
-                challenge_tour_hanoi();
-                break;
-            case VIEW_LEADERBOARD:
-                display_leaderboard();
-                break;
-            case VIEW_STATS:
-                display_player_stats();
-                break;
-            case EXIT:
-                printf("\n  Thanks for playing, %s! Keep coding! 🚀\n\n", current_player.name);
-                running = 0;
-                break;
-            default:
-                printf("\n  ❌ Invalid option! Please choose 1-8.\n");
-                pause_screen();
+    // --metrics, anywhere on the command line, dumps metrics and a trace at exit
+    int dump_metrics = 0;
+    for(int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--metrics") == 0) {
+            dump_metrics = 1;
+            for(int j = i; j + 1 < argc; j++) argv[j] = argv[j + 1];
+            argc--;
+            break;
         }
     }
+    #if !defined(NO_METRICS) && defined(__linux__)
+        // No SA_RESTART: the signal must interrupt a blocking read so the
+        // terminal loop dumps right away rather than after the next line
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = metrics_handle_signal;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGUSR1, &action, NULL);
+    #endif
+    
+    // Offline tools run before any game state is loaded
+    if (argc > 1 && strcmp(argv[1], "--build-catalog") == 0) {
+        return catalog_build(argc > 2 ? argv[2] : CATALOG_FILE);
+    }
+    if (argc > 1 && strcmp(argv[1], "--check-path") == 0) {
+        return path_check_main(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-paths") == 0) {
+        return path_bench_main(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--attempt-stats") == 0) {
+        return attempt_stats_main(argc, argv);
+    }
     
-    return 0;
-}
\ No newline at end of file
+    if (argc > 1 && strcmp(argv[1], "--bench-store") == 0) {
+        return store_bench_main(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--load-test") == 0) {
+        return load_test_main(argc, argv);
+    }
+    
+    game_state_open();
+    
+    int status = 0;
+    if (argc > 1 && strcmp(argv[1], "--server") == 0) {
+        #ifdef __linux__
+            status = run_server(argc > 2 ? argv[2] : SERVER_DEFAULT_ADDRESS);
+        #else
+            printf("❌ Server mode is only available on Linux.\n");
+            status = 1;
+        #endif
+    } else {
+        run_terminal();
+    }
+    
+    game_state_close();
+    
+    if (dump_metrics) {
+        if (metrics_dump()) printf("📈 Metrics written to %s, trace to %s\n", METRICS_FILE, TRACE_FILE);
+        else printf("⚠️  No metrics written (built with NO_METRICS, or the files are not writable).\n");
+    }
+    return status;
+}